@@ -1,7 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include<vector>
 
 using Pivot_f = size_t (*)(int *, size_t);
@@ -16,6 +31,18 @@ size_t uniformRandomPivot(int *data, size_t n)
     return (rand() % (n));
 }
 
+/**
+ * @brief @p pivotFunction(data, n) checked against the Pivot_f contract: the
+ * returned index has to be inside the window data[0..n]
+ */
+size_t checkedPivot(Pivot_f pivotFunction, int *data, size_t n)
+{
+    const size_t index = pivotFunction(data, n);
+    if (index > n)
+        throw std::runtime_error{ "pivot function returned an index outside of its window" };
+    return index;
+}
+
 
 
 void change(int* a, int* b) {
@@ -40,15 +67,22 @@ size_t partititon(std::vector<int>& v, int l, int r, size_t pivot) {
     change(&v[index], &v[r]);
     return index;
 }
-int quickSelect1(std::vector<int>& v, int k, Pivot_f pivotFunction)
+// 0-based k, v[left..right] must contain the kth element of v. Before every
+// partition the loop asks exhausted(window size) and stops once it returns
+// true; [left, right] is then the window that still holds the kth element
+// (left == right == k when the selection finished)
+template <typename Exhausted>
+int quickSelectRange1(std::vector<int>& v, int& left, int& right, int k, Pivot_f pivotFunction, Exhausted exhausted)
 {
-    k = k - 1;
-    int right = v.size() - 1;
-    int left = 0;
-    size_t pivotIndex = 0;
     while (right != left) {
-        pivotIndex = partititon(v, left, right, pivotFunction(v.data(), right - left) + left);
+        if (exhausted(static_cast<size_t>(right - left + 1))) {
+            return v[k];
+        }
+        const int pivotIndex =
+            static_cast<int>(partititon(v, left, right, checkedPivot(pivotFunction, v.data() + left, right - left) + left));
         if (k == pivotIndex) {
+            left  = k;
+            right = k;
             return v[k];
         }
         else if (k < pivotIndex) {
@@ -60,6 +94,15 @@ int quickSelect1(std::vector<int>& v, int k, Pivot_f pivotFunction)
     }
     return v[left];
 }
+// 0-based k, v[left..right] must contain the kth element of v
+int quickSelectRange1(std::vector<int>& v, int left, int right, int k, Pivot_f pivotFunction)
+{
+    return quickSelectRange1(v, left, right, k, pivotFunction, [](size_t) { return false; });
+}
+int quickSelect1(std::vector<int>& v, int k, Pivot_f pivotFunction)
+{
+    return quickSelectRange1(v, 0, v.size() - 1, k - 1, pivotFunction);
+}
 
 
 
@@ -84,7 +127,3821 @@ double medianDeterministicPivot1(std::vector<int>& v)
     return 0;
 }
 
+/**
+ * @brief lower and upper median of @p v from a single quickSelect1 run: once
+ * the lower middle element is in place, everything to the right of it is >= it,
+ * so the upper middle element is the minimum of the right part
+ */
+std::pair<int, int> medianPair1(std::vector<int>& v, Pivot_f pivotFunction)
+{
+    const int k     = (v.size() + 1) / 2;
+    const int lower = quickSelect1(v, k, pivotFunction);
+    if (v.size() % 2 == 1) {
+        return { lower, lower };
+    }
+    return { lower, *std::min_element(v.begin() + k, v.end()) };
+}
+
+
+
+// --------------------
+// Non-destructive selection into a reusable scratch buffer
+// --------------------
+
+/**
+ * @brief scratch buffer of the calling thread, reused by the const selection
+ * functions so that repeated calls do not allocate once it is large enough
+ */
+std::vector<int>& threadLocalScratch()
+{
+    thread_local std::vector<int> scratch;
+    return scratch;
+}
+
+std::pair<size_t, size_t> partitionThreeWay(int *data, size_t size, size_t pivot);
+
+/**
+ * @brief quickSelect1 that leaves @p v untouched: @p v is copied into
+ * @p scratch and the whole selection, including the choice of the first pivot,
+ * runs in place there (pivot functions may reorder their window, e.g.
+ * medianOfMediansPivot). @p scratch only grows, so once it has reached the
+ * largest input size the calls do not allocate. Afterwards
+ * scratch[0..v.size()) is partitioned around the returned element.
+ */
+int quickSelectConst1(const std::vector<int>& v, int k, Pivot_f pivotFunction, std::vector<int>& scratch)
+{
+    const size_t n = v.size();
+    scratch.resize(n);
+    std::copy(v.begin(), v.end(), scratch.begin());
+    if (n == 1) {
+        return scratch[0];
+    }
+
+    const size_t pivot      = checkedPivot(pivotFunction, scratch.data(), n - 1);
+    const int    pivotValue = scratch[pivot];
+    const auto [less, more] = partitionThreeWay(scratch.data(), n, pivot);
+
+    const size_t kth = k - 1;
+    if (kth < less) {
+        return quickSelectRange1(scratch, 0, less - 1, kth, pivotFunction);
+    }
+    if (kth >= more) {
+        return quickSelectRange1(scratch, more, n - 1, kth, pivotFunction);
+    }
+    return pivotValue;
+}
+
+double medianConst1(const std::vector<int>& v, Pivot_f pivotFunction, std::vector<int>& scratch)
+{
+    const int k     = (v.size() + 1) / 2;
+    const int lower = quickSelectConst1(v, k, pivotFunction, scratch);
+    if (v.size() % 2 == 1) {
+        return lower;
+    }
+    const int upper = *std::min_element(scratch.begin() + k, scratch.begin() + v.size());
+    return (static_cast<double>(lower) + upper) / 2.0;
+}
+
+
+
+// --------------------
+// Weighted selection: values with non-negative integer weights
+// --------------------
+
+/**
+ * @brief partititon that moves @p weights together with @p values and also
+ * returns the total weight of the elements that ended up left of the pivot
+ */
+size_t weightedPartition(
+    std::vector<int>&       values,
+    std::vector<long long>& weights,
+    int                     l,
+    int                     r,
+    size_t                  pivot,
+    long long&              lessWeight)
+{
+    std::swap(values[pivot], values[r]);
+    std::swap(weights[pivot], weights[r]);
+    const int pivotValue = values[r];
+
+    int index  = l;
+    lessWeight = 0;
+    for (int i = l; i < r; ++i) {
+        if (values[i] < pivotValue) {
+            lessWeight += weights[i];
+            std::swap(values[i], values[index]);
+            std::swap(weights[i], weights[index]);
+            index++;
+        }
+    }
+    std::swap(values[index], values[r]);
+    std::swap(weights[index], weights[r]);
+    return index;
+}
+
+/**
+ * @brief position of the element holding 1-based @p rank in the "expanded"
+ * order, where every value is repeated weight times, and which of its copies
+ * the rank hits (1 <= copy <= weight)
+ */
+struct WeightedPosition
+{
+    size_t    index;
+    long long copy;
+};
+
+/**
+ * @brief quickSelect1 over (values[i], weights[i]) that carries the weight of
+ * the left part instead of its size, expected O(n) regardless of the weights.
+ * Afterwards everything right of the returned index is >= its value.
+ */
+WeightedPosition weightedSelect1(
+    std::vector<int>&       values,
+    std::vector<long long>& weights,
+    long long               rank,
+    Pivot_f                 pivotFunction)
+{
+    int right = values.size() - 1;
+    int left  = 0;
+    while (right != left) {
+        long long  lessWeight = 0;
+        const auto pivotIndex = weightedPartition(
+            values, weights, left, right,
+            checkedPivot(pivotFunction, values.data() + left, right - left) + left, lessWeight);
+
+        if (rank <= lessWeight) {
+            right = pivotIndex - 1;
+        }
+        else if (rank <= lessWeight + weights[pivotIndex]) {
+            return { pivotIndex, rank - lessWeight };
+        }
+        else {
+            rank -= lessWeight + weights[pivotIndex];
+            left = pivotIndex + 1;
+        }
+    }
+    return { static_cast<size_t>(left), rank };
+}
+
+long long totalWeight(const std::vector<long long>& weights)
+{
+    long long res = 0;
+    for (const auto weight : weights)
+        res += weight;
+    return res;
+}
+
+/**
+ * @brief weighted quantile: the value at 1-based rank max(1, ceil(q * W)) of
+ * the expanded order (W is the total weight)
+ */
+int weightedQuantile1(std::vector<int>& values, std::vector<long long>& weights, double q, Pivot_f pivotFunction)
+{
+    const long long total = totalWeight(weights);
+    const long long rank  = std::clamp<long long>(std::ceil(q * total), 1, total);
+    return values[weightedSelect1(values, weights, rank, pivotFunction).index];
+}
+
+/**
+ * @brief weighted median, i.e. the median of the expanded array (average of the
+ * two middle elements for even W) found with a single selection: the upper
+ * middle element is either another copy of the lower one or the smallest
+ * positive-weight value right of it
+ */
+double weightedMedian1(std::vector<int>& values, std::vector<long long>& weights, Pivot_f pivotFunction)
+{
+    const long long total = totalWeight(weights);
+    const auto [index, copy] = weightedSelect1(values, weights, (total + 1) / 2, pivotFunction);
+
+    const int lower = values[index];
+    if (total % 2 == 1 || copy < weights[index]) {
+        return lower;
+    }
+
+    int upper = std::numeric_limits<int>::max();
+    for (size_t i = index + 1; i < values.size(); ++i) {
+        if (weights[i] > 0) {
+            upper = std::min(upper, values[i]);
+        }
+    }
+    return (static_cast<double>(lower) + upper) / 2.0;
+}
+
+
+
+// --------------------
+// Key/payload selection: rows stored as several arrays, arrays of structs or indices
+// --------------------
+
+/**
+ * @brief three-way partition over an abstract sequence: @p key(i) is the key of
+ * row i, @p swap(i, j) exchanges rows i and j (in however many arrays they live)
+ *
+ * @return std::pair<size_t, size_t> - [first, second) are the rows of
+ * [l, r) whose key equals the key of row @p pivot
+ */
+template <typename Key, typename Swap>
+std::pair<size_t, size_t> partitionThreeWayBy(size_t l, size_t r, size_t pivot, Key key, Swap swap)
+{
+    const int pivotValue = key(pivot);
+
+    size_t lt = l;
+    size_t i  = l;
+    size_t gt = r;
+    while (i < gt)
+    {
+        const int value = key(i);
+        if (value < pivotValue)
+            swap(lt++, i++);
+        else if (value > pivotValue)
+            swap(i, --gt);
+        else
+            ++i;
+    }
+    return { lt, gt };
+}
+
+/**
+ * @brief quickSelect1 loop over an abstract sequence of @p n rows, see
+ * partitionThreeWayBy. @p keyData must hold the key of every row at its
+ * current position (@p swap keeps it up to date), it is what @p pivotFunction
+ * looks at.
+ */
+template <typename Key, typename Swap>
+size_t selectByKeys(size_t n, int k, Pivot_f pivotFunction, int *keyData, Key key, Swap swap)
+{
+    const size_t target = k - 1;
+
+    size_t left  = 0;
+    size_t right = n;
+    while (right - left > 1)
+    {
+        const size_t pivot      = checkedPivot(pivotFunction, keyData + left, right - left - 1) + left;
+        const auto [less, more] = partitionThreeWayBy(left, right, pivot, key, swap);
+
+        if (target < less)
+            right = less;
+        else if (target >= more)
+            left = more;
+        else
+            return target;
+    }
+    return left;
+}
+
+/**
+ * @brief selectByKeys for rows whose keys are contiguous in @p keyData, or,
+ * with @p keyData = nullptr, scattered (array of structs, indices): those keys
+ * are first gathered into the thread-local scratch buffer, which is then
+ * swapped along with the rows, so the pivot function always gets a real key
+ * window and the partitions read keys sequentially.
+ *
+ * @return size_t - k - 1; rows [0, k - 1) have keys <= the kth key and rows
+ * after it have keys >= it
+ */
+template <typename Key, typename Swap>
+size_t selectBy(size_t n, int k, Pivot_f pivotFunction, int *keyData, Key key, Swap swap)
+{
+    if (keyData != nullptr)
+        return selectByKeys(n, k, pivotFunction, keyData, key, swap);
+
+    auto &keys = threadLocalScratch();
+    keys.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        keys[i] = key(i);
+
+    return selectByKeys(
+        n,
+        k,
+        pivotFunction,
+        keys.data(),
+        [&](size_t i) { return keys[i]; },
+        [&](size_t i, size_t j)
+        {
+            std::swap(keys[i], keys[j]);
+            swap(i, j);
+        });
+}
+
+/**
+ * @brief struct-of-arrays selection: partitions @p keys and moves every
+ * payload array (each of keys.size() elements) together with it, so that the
+ * first k rows of all arrays are the k rows with the smallest keys
+ */
+template <typename... Payloads>
+int quickSelectWithPayloads1(std::vector<int>& keys, int k, Pivot_f pivotFunction, std::vector<Payloads>&... payloads)
+{
+    const auto index = selectBy(
+        keys.size(),
+        k,
+        pivotFunction,
+        keys.data(),
+        [&](size_t i) { return keys[i]; },
+        [&](size_t i, size_t j)
+        {
+            std::swap(keys[i], keys[j]);
+            (std::swap(payloads[i], payloads[j]), ...);
+        });
+    return keys[index];
+}
+
+/**
+ * @brief array-of-structs selection: Row must have an int member "key"
+ */
+template <typename Row>
+int quickSelectRows1(std::vector<Row>& rows, int k, Pivot_f pivotFunction)
+{
+    const auto index = selectBy(
+        rows.size(),
+        k,
+        pivotFunction,
+        nullptr,
+        [&](size_t i) { return rows[i].key; },
+        [&](size_t i, size_t j) { std::swap(rows[i], rows[j]); });
+    return rows[index].key;
+}
+
+/**
+ * @brief indices of the @p k rows with the smallest keys, @p keys are not
+ * moved. The last returned index is the one of the kth key.
+ */
+std::vector<size_t> argSelect1(const std::vector<int>& keys, int k, Pivot_f pivotFunction)
+{
+    std::vector<size_t> indices(keys.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = i;
+
+    selectBy(
+        indices.size(),
+        k,
+        pivotFunction,
+        nullptr,
+        [&](size_t i) { return keys[indices[i]]; },
+        [&](size_t i, size_t j) { std::swap(indices[i], indices[j]); });
+
+    indices.resize(k);
+    return indices;
+}
+
+
+
+// --------------------
+// Anytime selection: quickSelect loop with a work budget or a deadline
+// --------------------
+
+/**
+ * @brief result of a selection that may have been stopped early: @p value is
+ * the element at position k at that moment, and its rank in sorted order
+ * (1-based) is guaranteed to be in [rankLow, rankHigh] - the window the
+ * quickSelect loop had not finished yet. The true kth element lies in the same
+ * range, so the rank error is at most rankHigh - rankLow.
+ */
+struct AnytimeSelection
+{
+    int value;
+    int rankLow;
+    int rankHigh;
+
+    bool exact() const { return rankLow == rankHigh; }
+};
+
+/**
+ * @brief quickSelectRange1 over the whole of @p v that asks @p exhausted(windowSize)
+ * before every partition and stops with the current window as soon as it
+ * returns true
+ */
+template <typename Exhausted>
+AnytimeSelection anytimeSelect1(std::vector<int>& v, int k, Pivot_f pivotFunction, Exhausted exhausted)
+{
+    int       left  = 0;
+    int       right = v.size() - 1;
+    const int value = quickSelectRange1(v, left, right, k - 1, pivotFunction, exhausted);
+    return { value, left + 1, right + 1 };
+}
+
+/**
+ * @brief anytime selection limited by @p budget element visits: a partition of
+ * a window of m elements costs m, a partition that would overrun the budget is
+ * not started
+ */
+AnytimeSelection quickSelectBudgeted1(std::vector<int>& v, int k, Pivot_f pivotFunction, size_t budget)
+{
+    size_t used = 0;
+    return anytimeSelect1(
+        v,
+        k,
+        pivotFunction,
+        [&](size_t work)
+        {
+            if (used + work > budget)
+                return true;
+            used += work;
+            return false;
+        });
+}
+
+/**
+ * @brief anytime selection that does not start a partition after @p deadline
+ */
+AnytimeSelection quickSelectDeadline1(
+    std::vector<int>&                     v,
+    int                                   k,
+    Pivot_f                               pivotFunction,
+    std::chrono::steady_clock::time_point deadline)
+{
+    return anytimeSelect1(
+        v,
+        k,
+        pivotFunction,
+        [&](size_t) { return std::chrono::steady_clock::now() >= deadline; });
+}
+
+
+
+// --------------------
+// Introselect: quickSelect with median-of-medians (BFPRT) fallback
+// --------------------
+
+void insertionSort(int *data, size_t size)
+{
+    for (size_t i = 1; i < size; ++i)
+    {
+        const int value = data[i];
+        size_t    j     = i;
+        for (; j > 0 && data[j - 1] > value; --j)
+            data[j] = data[j - 1];
+        data[j] = value;
+    }
+}
+
+/**
+ * @brief three-way (Dutch national flag) partition of data[0..size) around
+ * data[pivot]
+ *
+ * @return std::pair<size_t, size_t> - [first, second) is the range of elements
+ * equal to the pivot value; everything before it is smaller, everything after
+ * it is greater
+ */
+std::pair<size_t, size_t> partitionThreeWay(int *data, size_t size, size_t pivot)
+{
+    const int pivotValue = data[pivot];
+
+    size_t lt = 0;
+    size_t i  = 0;
+    size_t gt = size;
+    while (i < gt)
+    {
+        if (data[i] < pivotValue)
+            change(&data[lt++], &data[i++]);
+        else if (data[i] > pivotValue)
+            change(&data[i], &data[--gt]);
+        else
+            ++i;
+    }
+    return { lt, gt };
+}
+
+size_t medianOfMediansSelect(int *data, size_t size, size_t k);
+
+/**
+ * @brief median-of-medians (BFPRT) pivot with the Pivot_f contract: @p n is
+ * the index of the last element, so the segment is data[0..n]. Elements of the
+ * segment are rearranged (groups of 5 are sorted and their medians are moved to
+ * the front).
+ *
+ * The returned element is guaranteed to be greater than ~30% and less than ~30%
+ * of the segment, which bounds the selection built on top of it by O(n).
+ */
+size_t medianOfMediansPivot(int *data, size_t n)
+{
+    const size_t size = n + 1;
+    if (size <= 5)
+    {
+        insertionSort(data, size);
+        return (size - 1) / 2;
+    }
+
+    size_t medians = 0;
+    for (size_t i = 0; i < size; i += 5)
+    {
+        const size_t groupSize = std::min<size_t>(5, size - i);
+        insertionSort(data + i, groupSize);
+        change(&data[medians++], &data[i + (groupSize - 1) / 2]);
+    }
+
+    return medianOfMediansSelect(data, medians, (medians - 1) / 2);
+}
+
+/**
+ * @brief worst-case linear selection of the 0-based @p k th element of
+ * data[0..size) using medianOfMediansPivot for every partition
+ *
+ * @return size_t - index of the selected element (data[k] after the call)
+ */
+size_t medianOfMediansSelect(int *data, size_t size, size_t k)
+{
+    size_t left = 0;
+    while (size > 1)
+    {
+        const auto pivot        = medianOfMediansPivot(data + left, size - 1);
+        const auto [less, more] = partitionThreeWay(data + left, size, pivot);
+
+        if (k < left + less)
+        {
+            size = less;
+        }
+        else if (k >= left + more)
+        {
+            left += more;
+            size -= more;
+        }
+        else
+        {
+            return k;
+        }
+    }
+    return left;
+}
+
+/**
+ * @brief introspective selection: runs the quickSelect loop with @p pivotFunction
+ * while it makes progress, and switches to medianOfMediansPivot whenever two
+ * consecutive partitions fail to halve the active window. Keeps the fast path on
+ * well-behaved data and guarantees O(n) on adversarial inputs (e.g. sorted
+ * arrays with deterministicPivot). Equal keys are grouped by a three-way
+ * partition, so arrays with many duplicates are linear as well.
+ *
+ * @return size_t - index of the 0-based @p k th element of data[0..size)
+ */
+size_t introSelectRange(int *data, size_t size, size_t k, Pivot_f pivotFunction)
+{
+    size_t left = 0;
+
+    size_t checkpoint = size;
+    int    steps      = 0;
+    bool   stalled    = false;
+
+    while (size > 1)
+    {
+        const auto pivot = stalled ? medianOfMediansPivot(data + left, size - 1)
+                                   : checkedPivot(pivotFunction, data + left, size - 1);
+        const auto [less, more] = partitionThreeWay(data + left, size, pivot);
+
+        if (k < left + less)
+        {
+            size = less;
+        }
+        else if (k >= left + more)
+        {
+            left += more;
+            size -= more;
+        }
+        else
+        {
+            return k;
+        }
+
+        if (++steps == 2)
+        {
+            stalled    = size > checkpoint / 2;
+            checkpoint = size;
+            steps      = 0;
+        }
+    }
+    return left;
+}
+
+int introSelect1(std::vector<int>& v, int k, Pivot_f pivotFunction)
+{
+    return v[introSelectRange(v.data(), v.size(), k - 1, pivotFunction)];
+}
+
+double medianIntroselect1(std::vector<int>& v)
+{
+    if (v.size() % 2 == 0) {
+        return (introSelect1(v, (v.size() / 2), deterministicPivot) + introSelect1(v, (v.size() / 2) + 1, deterministicPivot)) / 2.0;
+    }
+    else {
+        return introSelect1(v, (v.size() + 1) / 2, deterministicPivot);
+    }
+}
+
+
+
+// --------------------
+// Floyd-Rivest: sampling selection with two bracketing pivots
+// --------------------
+
+// windows smaller than this are finished by introSelectRange
+const size_t kFloydRivestCutoff = 600;
+
+/**
+ * @brief partitions data[0..size) into three groups: < @p low, in
+ * [@p low, @p high] and > @p high. With @p highFirst the "> high" test is done
+ * first, which saves a comparison for every element above the range.
+ *
+ * @return std::pair<size_t, size_t> - [first, second) is the middle group
+ */
+std::pair<size_t, size_t>
+    partitionRange(int *data, size_t size, int low, int high, bool highFirst)
+{
+    size_t lt = 0;
+    size_t i  = 0;
+    size_t gt = size;
+    if (highFirst)
+    {
+        while (i < gt)
+        {
+            if (data[i] > high)
+                change(&data[i], &data[--gt]);
+            else if (data[i] < low)
+                change(&data[lt++], &data[i++]);
+            else
+                ++i;
+        }
+    }
+    else
+    {
+        while (i < gt)
+        {
+            if (data[i] < low)
+                change(&data[lt++], &data[i++]);
+            else if (data[i] > high)
+                change(&data[i], &data[--gt]);
+            else
+                ++i;
+        }
+    }
+    return { lt, gt };
+}
+
+/**
+ * @brief Floyd-Rivest selection of the 0-based @p k th element of data[0..size)
+ *
+ * While the window is large, a sample of ~size^(2/3) elements is taken and two
+ * of its elements bracketing the expected position of @p k are selected
+ * recursively. One partition pass around them leaves a middle group of
+ * ~size^(2/3) elements that contains @p k with high probability, so almost
+ * everything is discarded after one pass (about n + min(k, n - k) comparisons).
+ * Small windows are finished by introSelectRange with @p pivotFunction.
+ *
+ * @return size_t - index of the selected element (data[k] after the call)
+ */
+size_t floydRivestRange(int *data, size_t size, size_t k, Pivot_f pivotFunction)
+{
+    size_t left = 0;
+
+    while (size > kFloydRivestCutoff)
+    {
+        const double n          = static_cast<double>(size);
+        const double logN       = std::log(n);
+        const auto   sampleSize = static_cast<size_t>(0.5 * std::pow(n, 2.0 / 3.0));
+        const auto   gap = static_cast<size_t>(std::sqrt(sampleSize * logN) * 0.5) + 1;
+
+        // evenly spaced sample moved to the front of the window
+        const size_t step = size / sampleSize;
+        for (size_t i = 0; i < sampleSize; ++i)
+            change(&data[left + i], &data[left + i * step]);
+
+        const size_t kSample = (k - left) * sampleSize / size;
+        const size_t lo      = kSample > gap ? kSample - gap : 0;
+        const size_t hi      = std::min(sampleSize - 1, kSample + gap);
+
+        floydRivestRange(data + left, sampleSize, lo, pivotFunction);
+        floydRivestRange(data + left + lo, sampleSize - lo, hi - lo, pivotFunction);
+        const int low  = data[left + lo];
+        const int high = data[left + hi];
+
+        const bool highFirst    = (k - left) < size / 2;
+        const auto [less, more] = partitionRange(data + left, size, low, high, highFirst);
+
+        if (k < left + less)
+        {
+            size = less;
+        }
+        else if (k >= left + more)
+        {
+            left += more;
+            size -= more;
+        }
+        else
+        {
+            if (low == high)
+                return k;
+            if (more - less == size)
+                break;
+
+            left += less;
+            size = more - less;
+        }
+    }
+
+    return left + introSelectRange(data + left, size, k - left, pivotFunction);
+}
+
+int floydRivestSelect1(std::vector<int>& v, int k, Pivot_f pivotFunction)
+{
+    return v[floydRivestRange(v.data(), v.size(), k - 1, pivotFunction)];
+}
+
+
+
+// --------------------
+// Multiselect: several order statistics in one partitioning pass
+// --------------------
+
+/**
+ * @brief selects all 0-based ranks ks[0..count) (sorted) inside v[l..r] and
+ * writes the values into out[0..count). Each partititon call splits the rank
+ * list as well, so only segments that still contain requested ranks are
+ * processed: O(n log count) expected instead of O(count * n).
+ */
+void multiSelectRange(
+    std::vector<int>& v,
+    int               l,
+    int               r,
+    const int        *ks,
+    size_t            count,
+    int              *out,
+    Pivot_f           pivotFunction)
+{
+    while (count > 0)
+    {
+        if (l == r)
+        {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = v[l];
+            return;
+        }
+
+        const int p = partititon(v, l, r, checkedPivot(pivotFunction, v.data() + l, r - l) + l);
+
+        const int *end   = ks + count;
+        const int *equal = std::lower_bound(ks, end, p);
+        const int *more  = std::upper_bound(equal, end, p);
+
+        for (const int *it = equal; it != more; ++it)
+            out[it - ks] = v[p];
+
+        const size_t lessCount = equal - ks;
+        const size_t moreCount = end - more;
+
+        // recurse into the side with fewer ranks, keep looping on the other one
+        if (lessCount < moreCount)
+        {
+            multiSelectRange(v, l, p - 1, ks, lessCount, out, pivotFunction);
+            out += more - ks;
+            ks    = more;
+            count = moreCount;
+            l     = p + 1;
+        }
+        else
+        {
+            multiSelectRange(v, p + 1, r, more, moreCount, out + (more - ks), pivotFunction);
+            count = lessCount;
+            r     = p - 1;
+        }
+    }
+}
+
+std::vector<int> multiSelect1(std::vector<int>& v, const std::vector<int>& ks, Pivot_f pivotFunction)
+{
+    std::vector<int> ranks(ks.size());
+    for (size_t i = 0; i < ks.size(); ++i)
+        ranks[i] = ks[i] - 1;
+
+    std::vector<int> res(ks.size());
+    multiSelectRange(v, 0, v.size() - 1, ranks.data(), ranks.size(), res.data(), pivotFunction);
+    return res;
+}
+
+
+
+// --------------------
+// Radix select: digit histograms instead of pivots
+// --------------------
+
+/**
+ * @brief kth order statistics (1-based @p k) of 32-bit ints with MSD radix
+ * histograms: three passes over 11/11/10-bit digits, each pass counts the
+ * digits of the remaining candidates, finds the bucket holding rank k and
+ * compacts that bucket to the front of @p v. Counting and compaction are
+ * branch-free and there is no pivot, so the input order does not matter.
+ * Signed values are mapped to unsigned keys by flipping the sign bit, which
+ * keeps INT_MIN..INT_MAX in order.
+ */
+int radixSelect1(std::vector<int>& v, int k)
+{
+    constexpr int      kDigitBits[] = { 11, 11, 10 };
+    constexpr uint32_t kSignBit     = 0x80000000u;
+
+    std::vector<size_t> histogram(size_t{ 1 } << 11);
+
+    size_t rank  = k - 1;
+    size_t count = v.size();
+    int    shift = 32;
+
+    for (const int bits : kDigitBits)
+    {
+        if (count == 1)
+            break;
+
+        shift -= bits;
+        const uint32_t mask = (uint32_t{ 1 } << bits) - 1;
+
+        std::fill(histogram.begin(), histogram.begin() + (mask + 1), 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t key = static_cast<uint32_t>(v[i]) ^ kSignBit;
+            ++histogram[(key >> shift) & mask];
+        }
+
+        uint32_t bucket = 0;
+        while (rank >= histogram[bucket])
+            rank -= histogram[bucket++];
+
+        // every candidate shares this digit, nothing to compact
+        if (histogram[bucket] == count)
+            continue;
+
+        size_t write = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const int      value = v[i];
+            const uint32_t key   = static_cast<uint32_t>(value) ^ kSignBit;
+            v[write]             = value;
+            write += ((key >> shift) & mask) == bucket;
+        }
+        count = write;
+    }
+
+    return v[rank];
+}
+
+
 
+// --------------------
+// Parallel quickselect: chunked partition + prefix sums + parallel compaction
+// --------------------
+
+// windows smaller than this are finished sequentially by introSelectRange
+const size_t kParallelQuickSelectCutoff = size_t{ 1 } << 14;
+
+/**
+ * @brief runs fn(0), ..., fn(threads - 1) on separate threads (fn(0) on the
+ * calling one) and waits for all of them
+ */
+template <typename F>
+void parallelFor(size_t threads, F fn)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t)
+        workers.emplace_back(fn, t);
+
+    fn(size_t{ 0 });
+
+    for (auto &worker : workers)
+        worker.join();
+}
+
+/**
+ * @brief quickselect of the 1-based @p k th element on @p threads threads
+ *
+ * Every round picks a pivot from the active window with a generator seeded by
+ * @p seed (so the work done is reproducible), each thread counts the elements
+ * less than / equal to the pivot in its own chunk, the counts are combined with
+ * a prefix sum and the side holding rank k is compacted in parallel into a
+ * second buffer at the offsets given by the prefix sum. Windows below
+ * @p cutoff are finished sequentially.
+ */
+int parallelQuickSelect1(
+    std::vector<int>& v,
+    int               k,
+    size_t            threads,
+    unsigned          seed,
+    size_t            cutoff = kParallelQuickSelectCutoff)
+{
+    threads = std::max<size_t>(threads, 1);
+
+    auto gen = std::mt19937{ seed };
+
+    std::vector<int> buffer;
+    int   *src    = v.data();
+    int   *dst    = nullptr;
+    size_t active = v.size();
+    size_t rank   = k - 1;
+
+    std::vector<size_t> less(threads);
+    std::vector<size_t> equal(threads);
+    std::vector<size_t> offsets(threads);
+
+    while (active > std::max<size_t>(cutoff, threads))
+    {
+        if (buffer.empty())
+        {
+            buffer.resize(v.size());
+            dst = buffer.data();
+        }
+
+        const int pivotValue =
+            src[std::uniform_int_distribution<size_t>{ 0, active - 1 }(gen)];
+
+        const auto chunkBegin = [&](size_t t) { return active * t / threads; };
+
+        parallelFor(
+            threads,
+            [&](size_t t)
+            {
+                size_t lessCount  = 0;
+                size_t equalCount = 0;
+                for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+                {
+                    lessCount += src[i] < pivotValue;
+                    equalCount += src[i] == pivotValue;
+                }
+                less[t]  = lessCount;
+                equal[t] = equalCount;
+            });
+
+        size_t totalLess  = 0;
+        size_t totalEqual = 0;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            totalLess += less[t];
+            totalEqual += equal[t];
+        }
+
+        if (rank >= totalLess && rank < totalLess + totalEqual)
+            return pivotValue;
+
+        const bool keepLess = rank < totalLess;
+        if (!keepLess)
+            rank -= totalLess + totalEqual;
+
+        size_t kept = 0;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            offsets[t] = kept;
+            kept += keepLess ? less[t]
+                             : chunkBegin(t + 1) - chunkBegin(t) - less[t] - equal[t];
+        }
+
+        parallelFor(
+            threads,
+            [&](size_t t)
+            {
+                // writes stay inside this chunk's slice of dst, the
+                // neighbouring slices are filled concurrently
+                int *out = dst + offsets[t];
+                for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+                {
+                    const int value = src[i];
+                    if (keepLess ? value < pivotValue : value > pivotValue)
+                        *out++ = value;
+                }
+            });
+
+        std::swap(src, dst);
+        active = kept;
+    }
+
+    return src[introSelectRange(src, active, rank, deterministicPivot)];
+}
+
+
+
+// --------------------
+// Sharded selection: quickselect across separately owned vectors
+// --------------------
+
+// once this few elements are left in all shards together they are gathered
+// and finished by introSelectRange
+const size_t kShardedSelectCutoff = 1024;
+
+/**
+ * @brief kth order statistics (1-based @p k) of the union of @p shards without
+ * concatenating them
+ *
+ * Every round draws a pivot uniformly from the active elements of all shards
+ * (generator seeded by @p seed), "broadcasts" it, each shard three-way
+ * partitions its active window in place and reports its counts. The counts
+ * decide which side holds rank k, every shard then shrinks its window to that
+ * side; shards whose window became empty are dropped from the list of live
+ * shards and not visited in later rounds. With @p threads > 1 live shards are
+ * processed concurrently (the ith live shard on thread i % threads). Elements
+ * are reordered inside their shards but never move between them.
+ */
+int shardedSelect1(
+    std::vector<std::vector<int>>& shards,
+    long long                      k,
+    size_t                         threads,
+    unsigned                       seed   = 47,
+    size_t                         cutoff = kShardedSelectCutoff)
+{
+    const size_t count = shards.size();
+    threads            = std::clamp<size_t>(threads, 1, std::max<size_t>(count, 1));
+
+    std::vector<size_t> lo(count, 0);
+    std::vector<size_t> hi(count);
+    std::vector<size_t> less(count);
+    std::vector<size_t> more(count);
+
+    // shards whose window is not empty
+    std::vector<size_t> live;
+    live.reserve(count);
+
+    uint64_t active = 0;
+    for (size_t s = 0; s < count; ++s)
+    {
+        hi[s] = shards[s].size();
+        active += hi[s];
+        if (hi[s] > 0)
+            live.push_back(s);
+    }
+
+    auto     gen  = std::mt19937{ seed };
+    uint64_t rank = k - 1;
+
+    while (active > cutoff)
+    {
+        auto pick = std::uniform_int_distribution<uint64_t>{ 0, active - 1 }(gen);
+        auto shard = live.begin();
+        for (; pick >= hi[*shard] - lo[*shard]; ++shard)
+            pick -= hi[*shard] - lo[*shard];
+        const int pivotValue = shards[*shard][lo[*shard] + pick];
+
+        const auto partitionShard = [&](size_t s)
+        {
+            const auto [l, m] = partitionRange(
+                shards[s].data() + lo[s], hi[s] - lo[s], pivotValue, pivotValue, false);
+            less[s] = l;
+            more[s] = m;
+        };
+        if (threads == 1)
+        {
+            for (const auto s : live)
+                partitionShard(s);
+        }
+        else
+        {
+            parallelFor(
+                threads,
+                [&](size_t t)
+                {
+                    for (size_t i = t; i < live.size(); i += threads)
+                        partitionShard(live[i]);
+                });
+        }
+
+        uint64_t totalLess  = 0;
+        uint64_t totalEqual = 0;
+        for (const auto s : live)
+        {
+            totalLess += less[s];
+            totalEqual += more[s] - less[s];
+        }
+
+        if (rank >= totalLess && rank < totalLess + totalEqual)
+            return pivotValue;
+
+        const bool keepLess = rank < totalLess;
+        if (!keepLess)
+            rank -= totalLess + totalEqual;
+
+        active = 0;
+        std::erase_if(
+            live,
+            [&](size_t s)
+            {
+                if (keepLess)
+                    hi[s] = lo[s] + less[s];
+                else
+                    lo[s] += more[s];
+                active += hi[s] - lo[s];
+                return hi[s] == lo[s];
+            });
+    }
+
+    std::vector<int> rest;
+    rest.reserve(active);
+    for (const auto s : live)
+        rest.insert(rest.end(), shards[s].begin() + lo[s], shards[s].begin() + hi[s]);
+
+    return rest[introSelectRange(rest.data(), rest.size(), rank, deterministicPivot)];
+}
+
+double shardedMedian1(std::vector<std::vector<int>>& shards, size_t threads)
+{
+    long long n = 0;
+    for (const auto &shard : shards)
+        n += shard.size();
+
+    const int lower = shardedSelect1(shards, (n + 1) / 2, threads);
+    if (n % 2 == 1)
+        return lower;
+
+    const int upper = shardedSelect1(shards, n / 2 + 1, threads);
+    return (static_cast<double>(lower) + upper) / 2.0;
+}
+
+
+
+// --------------------
+// Multi-pass selection over read-only sources
+// --------------------
+
+/**
+ * @brief read-only source over ints that are already in memory (a plain array
+ * or a memory-mapped file)
+ */
+class SpanSource
+{
+public:
+    SpanSource(const int *data, size_t size) : _data{ data }, _size{ size } {}
+
+    size_t size() const { return _size; }
+
+    template <typename F>
+    void forEachBlock(F fn) const
+    {
+        fn(_data, _size);
+    }
+
+private:
+    const int *_data;
+    size_t     _size;
+};
+
+/**
+ * @brief read-only source streaming a binary file of native-endian int32
+ * values block by block, each pass reopens the file and reads it sequentially
+ */
+class Int32FileSource
+{
+public:
+    Int32FileSource(std::filesystem::path path, size_t blockSize = size_t{ 1 } << 16)
+        : _path{ std::move(path) }, _blockSize{ blockSize }
+    {
+        const auto bytes = std::filesystem::file_size(_path);
+        if (bytes % sizeof(int32_t) != 0)
+            throw std::runtime_error{ "Int32FileSource: file size is not a multiple of 4: " +
+                                      _path.string() };
+        _size = bytes / sizeof(int32_t);
+    }
+
+    size_t size() const { return _size; }
+
+    template <typename F>
+    void forEachBlock(F fn) const
+    {
+        std::ifstream in{ _path, std::ios::binary };
+        if (!in)
+            throw std::runtime_error{ "Int32FileSource: cannot open " + _path.string() };
+
+        std::vector<int> block(_blockSize);
+        size_t           left = _size;
+        while (left > 0)
+        {
+            const size_t count = std::min(left, _blockSize);
+            in.read(reinterpret_cast<char *>(block.data()), count * sizeof(int32_t));
+            if (!in)
+                throw std::runtime_error{ "Int32FileSource: cannot read " + _path.string() };
+
+            fn(static_cast<const int *>(block.data()), count);
+            left -= count;
+        }
+    }
+
+private:
+    std::filesystem::path _path;
+    size_t                _blockSize;
+    size_t                _size;
+};
+
+/**
+ * @brief exact kth order statistics (1-based @p k) of a read-only @p source with
+ * O(@p memoryBudget) memory and a few sequential passes
+ *
+ * Every pass narrows a value interval: elements inside it are counted in a
+ * histogram of at most @p memoryBudget power-of-two wide buckets and the bucket
+ * holding rank k becomes the next interval (each pass resolves
+ * log2(memoryBudget) bits of the answer). Once the interval holds at most
+ * @p memoryBudget elements, one more pass copies them out and the rest is an
+ * in-memory selection. @p memoryBudget = 0 means sqrt(size), which resolves
+ * 32-bit values in about 3 passes for 10^9 elements.
+ *
+ * With @p kWithNext the passes also keep the minimum of every bucket, so the
+ * smallest value above the chosen bucket is known and the (k + 1)th element
+ * (k < size) comes out of the same passes as the second member of the pair.
+ *
+ * Source must provide size() and forEachBlock(fn), where fn receives
+ * (const int *data, size_t count) for consecutive blocks of the data.
+ */
+template <bool kWithNext, typename Source>
+std::pair<int, int> multiPassSelectImpl(const Source &source, long long k, size_t memoryBudget)
+{
+    if (memoryBudget == 0)
+        memoryBudget = static_cast<size_t>(std::sqrt(static_cast<double>(source.size())));
+    memoryBudget = std::max<size_t>(memoryBudget, 2);
+
+    int64_t  lo   = std::numeric_limits<int>::min();
+    int64_t  hi   = std::numeric_limits<int>::max();
+    uint64_t rank = k - 1;
+
+    // smallest value above the current interval
+    int next = std::numeric_limits<int>::max();
+
+    std::vector<uint64_t> histogram;
+    std::vector<int>      bucketMin;
+    while (true)
+    {
+        const uint64_t span  = static_cast<uint64_t>(hi - lo);
+        int            shift = 0;
+        while ((span >> shift) >= memoryBudget)
+            ++shift;
+
+        histogram.assign((span >> shift) + 1, 0);
+        if constexpr (kWithNext)
+            bucketMin.assign(histogram.size(), std::numeric_limits<int>::max());
+        source.forEachBlock(
+            [&](const int *data, size_t count)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const int64_t value = data[i];
+                    if (value >= lo && value <= hi)
+                    {
+                        const uint64_t bucket = static_cast<uint64_t>(value - lo) >> shift;
+                        ++histogram[bucket];
+                        if constexpr (kWithNext)
+                            bucketMin[bucket] = std::min(bucketMin[bucket], data[i]);
+                    }
+                }
+            });
+
+        size_t bucket = 0;
+        while (rank >= histogram[bucket])
+            rank -= histogram[bucket++];
+
+        if constexpr (kWithNext)
+        {
+            for (size_t b = bucket + 1; b < histogram.size(); ++b)
+            {
+                if (histogram[b] > 0)
+                {
+                    next = bucketMin[b];
+                    break;
+                }
+            }
+        }
+
+        lo = lo + (static_cast<int64_t>(bucket) << shift);
+        hi = std::min(hi, lo + (int64_t{ 1 } << shift) - 1);
+
+        if (lo == hi)
+            return { static_cast<int>(lo), rank + 1 < histogram[bucket] ? static_cast<int>(lo) : next };
+        if (histogram[bucket] <= memoryBudget)
+            break;
+    }
+
+    std::vector<int> candidates;
+    candidates.reserve(memoryBudget);
+    source.forEachBlock(
+        [&](const int *data, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (data[i] >= lo && data[i] <= hi)
+                    candidates.push_back(data[i]);
+            }
+        });
+
+    const size_t index =
+        introSelectRange(candidates.data(), candidates.size(), rank, deterministicPivot);
+    if constexpr (kWithNext)
+    {
+        // candidates after index are >= the kth element
+        if (index + 1 < candidates.size())
+            next = *std::min_element(candidates.begin() + index + 1, candidates.end());
+    }
+    return { candidates[index], next };
+}
+
+/**
+ * @brief exact kth order statistics (1-based @p k) of a read-only @p source,
+ * see multiPassSelectImpl
+ */
+template <typename Source>
+int multiPassSelect1(const Source &source, long long k, size_t memoryBudget = 0)
+{
+    return multiPassSelectImpl<false>(source, k, memoryBudget).first;
+}
+
+/**
+ * @brief median of a read-only @p source, see multiPassSelectImpl: for even
+ * sizes both middle elements come from one run of passes
+ */
+template <typename Source>
+double multiPassMedian1(const Source &source, size_t memoryBudget = 0)
+{
+    const long long n = source.size();
+    if (n % 2 == 1)
+        return multiPassSelect1(source, (n + 1) / 2, memoryBudget);
+
+    const auto [lower, upper] = multiPassSelectImpl<true>(source, n / 2, memoryBudget);
+    return (static_cast<double>(lower) + upper) / 2.0;
+}
+
+
+
+// --------------------
+// Top-k: the k largest values of an array or of a stream
+// --------------------
+
+/**
+ * @brief k largest values of @p v in descending order (all of them if k >= size)
+ *
+ * One introSelectRange for the (size - k)th element leaves the k largest in the
+ * tail of @p v, so only that tail has to be sorted: O(n + k log k) instead of
+ * sorting the whole array. Reorders @p v.
+ */
+std::vector<int> topK1(std::vector<int>& v, size_t k, Pivot_f pivotFunction)
+{
+    k = std::min(k, v.size());
+    if (k == 0)
+        return {};
+
+    const size_t first = v.size() - k;
+    if (first > 0)
+        introSelectRange(v.data(), v.size(), first, pivotFunction);
+
+    std::vector<int> result(v.begin() + first, v.end());
+    std::sort(result.begin(), result.end(), std::greater<>{});
+    return result;
+}
+
+// values are tested against the current threshold in blocks of this size
+constexpr size_t kTopKFilterBlock = 64;
+
+/**
+ * @brief running top-k of an unbounded stream in O(k) memory
+ *
+ * Keeps a min-heap of the k largest values seen so far. Once it is full its
+ * root is the threshold a new value has to beat, and push(data, count) first
+ * checks whole blocks against it with a branch-free OR-reduction the compiler
+ * vectorizes. Only blocks holding at least one candidate go through the heap
+ * element by element, which on long streams is a vanishing fraction of them.
+ */
+class StreamingTopK
+{
+public:
+    explicit StreamingTopK(size_t k) : _k{ k } { _heap.reserve(k); }
+
+    void push(int value)
+    {
+        if (_heap.size() < _k)
+        {
+            _heap.push_back(value);
+            std::push_heap(_heap.begin(), _heap.end(), std::greater<>{});
+        }
+        else if (_k > 0 && value > _heap.front())
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), std::greater<>{});
+            _heap.back() = value;
+            std::push_heap(_heap.begin(), _heap.end(), std::greater<>{});
+        }
+    }
+
+    void push(const int *data, size_t count)
+    {
+        size_t i = 0;
+        while (i < count && _heap.size() < _k)
+            push(data[i++]);
+        if (_k == 0)
+            return;
+
+        for (; i + kTopKFilterBlock <= count; i += kTopKFilterBlock)
+        {
+            const int threshold = _heap.front();
+
+            int candidates = 0;
+            for (size_t j = 0; j < kTopKFilterBlock; ++j)
+                candidates |= data[i + j] > threshold;
+
+            if (candidates == 0)
+                continue;
+            for (size_t j = 0; j < kTopKFilterBlock; ++j)
+                push(data[i + j]);
+        }
+
+        for (; i < count; ++i)
+            push(data[i]);
+    }
+
+    size_t size() const { return _heap.size(); }
+
+    /**
+     * @brief k largest values pushed so far, in descending order
+     */
+    std::vector<int> values() const
+    {
+        std::vector<int> result = _heap;
+        std::sort(result.begin(), result.end(), std::greater<>{});
+        return result;
+    }
+
+private:
+    size_t           _k;
+    std::vector<int> _heap;
+};
+
+/**
+ * @brief k largest values of a read-only @p source (see multiPassSelect1) in
+ * descending order, in one pass and O(k) memory
+ */
+template <typename Source>
+std::vector<int> topKStream1(const Source &source, size_t k)
+{
+    StreamingTopK top{ k };
+    source.forEachBlock([&](const int *data, size_t count) { top.push(data, count); });
+    return top.values();
+}
+
+// --------------------
+// k-d tree: median split per level with selectBy
+// --------------------
+
+// subtrees smaller than this are built on the calling thread
+constexpr size_t kKdTreeParallelCutoff = size_t{ 1 } << 15;
+
+template <size_t D>
+using KdPoint = std::array<int, D>;
+
+/**
+ * @brief static k-d tree over D-dimensional integer points
+ *
+ * The tree is implicit in the order of points(): the subtree over [l, r) splits
+ * at m = (l + r) / 2 along axis depth % D, points [l, m) are <= points[m] on
+ * that axis and points [m + 1, r) are >= it. Building is one selectBy per node,
+ * O(n log n) in total; the halves of subtrees with at least @p cutoff points are
+ * built on separate threads while @p threads allows it.
+ *
+ * Coordinates are expected to be within +-2^29, so that squared distances fit
+ * in long long for D < 8.
+ */
+template <size_t D>
+class KdTree
+{
+public:
+    KdTree(
+        std::vector<KdPoint<D>> points,
+        size_t                  threads       = 1,
+        Pivot_f                 pivotFunction = uniformRandomPivot,
+        size_t                  cutoff        = kKdTreeParallelCutoff)
+        : _points{ std::move(points) }, _pivotFunction{ pivotFunction }, _cutoff{ cutoff }
+    {
+        build(0, _points.size(), 0, std::max<size_t>(threads, 1));
+    }
+
+    const std::vector<KdPoint<D>>& points() const { return _points; }
+    size_t                         size() const { return _points.size(); }
+
+    static long long distance2(const KdPoint<D>& a, const KdPoint<D>& b)
+    {
+        long long result = 0;
+        for (size_t axis = 0; axis < D; ++axis)
+        {
+            const long long diff = static_cast<long long>(a[axis]) - b[axis];
+            result += diff * diff;
+        }
+        return result;
+    }
+
+    /**
+     * @brief index in points() of a point closest to @p query (squared euclidean
+     * distance), the tree must not be empty
+     */
+    size_t nearest(const KdPoint<D>& query) const
+    {
+        size_t    best         = 0;
+        long long bestDistance = std::numeric_limits<long long>::max();
+        nearest(0, _points.size(), 0, query, best, bestDistance);
+        return best;
+    }
+
+    /**
+     * @brief indices in points() of all points inside the box [lo, hi]
+     * (inclusive on every axis)
+     */
+    std::vector<size_t> range(const KdPoint<D>& lo, const KdPoint<D>& hi) const
+    {
+        std::vector<size_t> result;
+        range(0, _points.size(), 0, lo, hi, result);
+        return result;
+    }
+
+private:
+    void build(size_t l, size_t r, size_t depth, size_t threads)
+    {
+        if (r - l <= 1)
+            return;
+
+        const size_t m    = l + (r - l) / 2;
+        const size_t axis = depth % D;
+        selectBy(
+            r - l,
+            m - l + 1,
+            _pivotFunction,
+            nullptr,
+            [&](size_t i) { return _points[l + i][axis]; },
+            [&](size_t i, size_t j) { std::swap(_points[l + i], _points[l + j]); });
+
+        if (threads > 1 && r - l >= _cutoff)
+        {
+            std::thread left{ [&] { build(l, m, depth + 1, threads / 2); } };
+            build(m + 1, r, depth + 1, threads - threads / 2);
+            left.join();
+        }
+        else
+        {
+            build(l, m, depth + 1, 1);
+            build(m + 1, r, depth + 1, 1);
+        }
+    }
+
+    void nearest(
+        size_t            l,
+        size_t            r,
+        size_t            depth,
+        const KdPoint<D>& query,
+        size_t&           best,
+        long long&        bestDistance) const
+    {
+        if (l >= r)
+            return;
+
+        const size_t m    = l + (r - l) / 2;
+        const size_t axis = depth % D;
+
+        const long long distance = distance2(_points[m], query);
+        if (distance < bestDistance)
+        {
+            best         = m;
+            bestDistance = distance;
+        }
+
+        // descend into the side of the split holding the query first, the other
+        // side only matters if the splitting plane is closer than the best point
+        const long long diff = static_cast<long long>(query[axis]) - _points[m][axis];
+        if (diff < 0)
+            nearest(l, m, depth + 1, query, best, bestDistance);
+        else
+            nearest(m + 1, r, depth + 1, query, best, bestDistance);
+
+        if (diff * diff < bestDistance)
+        {
+            if (diff < 0)
+                nearest(m + 1, r, depth + 1, query, best, bestDistance);
+            else
+                nearest(l, m, depth + 1, query, best, bestDistance);
+        }
+    }
+
+    void range(
+        size_t               l,
+        size_t               r,
+        size_t               depth,
+        const KdPoint<D>&    lo,
+        const KdPoint<D>&    hi,
+        std::vector<size_t>& result) const
+    {
+        if (l >= r)
+            return;
+
+        const size_t m    = l + (r - l) / 2;
+        const size_t axis = depth % D;
+        const auto&  p    = _points[m];
+
+        bool inside = true;
+        for (size_t i = 0; i < D; ++i)
+            inside = inside && lo[i] <= p[i] && p[i] <= hi[i];
+        if (inside)
+            result.push_back(m);
+
+        if (lo[axis] <= p[axis])
+            range(l, m, depth + 1, lo, hi, result);
+        if (hi[axis] >= p[axis])
+            range(m + 1, r, depth + 1, lo, hi, result);
+    }
+
+    std::vector<KdPoint<D>> _points;
+    Pivot_f                 _pivotFunction;
+    size_t                  _cutoff;
+};
+
+// --------------------
+// Running and sliding-window median: two heaps with lazy deletion
+// --------------------
+
+/**
+ * @brief median of a multiset that grows (and optionally shrinks) one value at
+ * a time: O(log n) insert/erase, O(1) median
+ *
+ * The lower half lives in a max-heap, the upper half in a min-heap, both plain
+ * contiguous arrays driven by std::push_heap/pop_heap. The lower half holds the
+ * extra element for odd sizes, so its root is the lower median. Erased values
+ * are only counted in a pending table and dropped once they reach a heap root,
+ * which keeps erase logarithmic but lets heaps hold up to as many stale entries
+ * as there were erases since they last surfaced (bounded by a rebuild once they
+ * outnumber the live entries).
+ */
+class RunningMedian
+{
+public:
+    size_t size() const { return _lowSize + _highSize; }
+    bool   empty() const { return size() == 0; }
+
+    void insert(int value)
+    {
+        if (_lowSize == 0 || value <= _low.front())
+        {
+            pushHeap(_low, value, std::less<>{});
+            ++_lowSize;
+        }
+        else
+        {
+            pushHeap(_high, value, std::greater<>{});
+            ++_highSize;
+        }
+        rebalance();
+    }
+
+    /**
+     * @brief inserts all of @p values; batches at least as large as the current
+     * contents are merged in O(n + m) by one introSelectRange split and two
+     * make_heap calls instead of m heap insertions
+     */
+    void insert(const std::vector<int>& values)
+    {
+        if (values.size() < size())
+        {
+            for (const auto value : values)
+                insert(value);
+            return;
+        }
+
+        rebuild(values.data(), values.size());
+    }
+
+    /**
+     * @brief removes one occurrence of @p value, which has to be present
+     */
+    void erase(int value)
+    {
+        ++_pending[value];
+        if (value <= _low.front())
+        {
+            --_lowSize;
+            prune(_low, std::less<>{});
+        }
+        else
+        {
+            --_highSize;
+            prune(_high, std::greater<>{});
+        }
+        rebalance();
+
+        // stale entries deep inside a heap may never reach its root (e.g. old
+        // small values of an increasing series in the lower heap); once they
+        // outnumber the live ones, drop them all at amortized O(1) per erase
+        if (_low.size() + _high.size() > 2 * size() + kCompactSlack)
+            rebuild(nullptr, 0);
+    }
+
+    int lowerMedian() const { return _low.front(); }
+    int upperMedian() const { return _lowSize > _highSize ? _low.front() : _high.front(); }
+
+    /**
+     * @brief median of the current contents, which must not be empty
+     */
+    double median() const
+    {
+        return (static_cast<double>(lowerMedian()) + upperMedian()) / 2.0;
+    }
+
+private:
+    static constexpr size_t kCompactSlack = 64;
+
+    /**
+     * @brief rebuilds both heaps from their live entries plus data[0..count)
+     */
+    void rebuild(const int *data, size_t count)
+    {
+        std::vector<int> all;
+        all.reserve(size() + count);
+        for (const auto* heap : { &_low, &_high })
+        {
+            for (const auto value : *heap)
+            {
+                if (!takePending(value))
+                    all.push_back(value);
+            }
+        }
+        all.insert(all.end(), data, data + count);
+
+        _lowSize  = 0;
+        _highSize = 0;
+        _low.clear();
+        _high.clear();
+        if (all.empty())
+            return;
+
+        const size_t middle = (all.size() - 1) / 2;
+        introSelectRange(all.data(), all.size(), middle, deterministicPivot);
+
+        _low.assign(all.begin(), all.begin() + middle + 1);
+        _high.assign(all.begin() + middle + 1, all.end());
+        std::make_heap(_low.begin(), _low.end(), std::less<>{});
+        std::make_heap(_high.begin(), _high.end(), std::greater<>{});
+        _lowSize  = _low.size();
+        _highSize = _high.size();
+    }
+
+    template <typename Compare>
+    static void pushHeap(std::vector<int>& heap, int value, Compare compare)
+    {
+        heap.push_back(value);
+        std::push_heap(heap.begin(), heap.end(), compare);
+    }
+
+    template <typename Compare>
+    static int popHeap(std::vector<int>& heap, Compare compare)
+    {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const int value = heap.back();
+        heap.pop_back();
+        return value;
+    }
+
+    bool takePending(int value)
+    {
+        const auto it = _pending.find(value);
+        if (it == _pending.end())
+            return false;
+        if (--it->second == 0)
+            _pending.erase(it);
+        return true;
+    }
+
+    template <typename Compare>
+    void prune(std::vector<int>& heap, Compare compare)
+    {
+        while (!heap.empty() && takePending(heap.front()))
+            popHeap(heap, compare);
+    }
+
+    void rebalance()
+    {
+        if (_lowSize > _highSize + 1)
+        {
+            pushHeap(_high, popHeap(_low, std::less<>{}), std::greater<>{});
+            --_lowSize;
+            ++_highSize;
+            prune(_low, std::less<>{});
+        }
+        else if (_lowSize < _highSize)
+        {
+            pushHeap(_low, popHeap(_high, std::greater<>{}), std::less<>{});
+            ++_lowSize;
+            --_highSize;
+            prune(_high, std::greater<>{});
+        }
+    }
+
+    std::vector<int> _low;
+    std::vector<int> _high;
+    size_t           _lowSize  = 0;
+    size_t           _highSize = 0;
+
+    // value -> number of its erased copies still stored in the heaps
+    std::unordered_map<int, size_t> _pending;
+};
+
+/**
+ * @brief medians of all @p window long windows of data[0..size): out[i] is the
+ * median of data[i..i + window), size - window + 1 values are written
+ *
+ * One RunningMedian slides over the data, so every step is an insert and an
+ * erase, O(log window) instead of a selection over the whole window.
+ */
+void slidingWindowMedian1(const int *data, size_t size, size_t window, double *out)
+{
+    RunningMedian median;
+    median.insert(std::vector<int>(data, data + window));
+    out[0] = median.median();
+
+    for (size_t i = window; i < size; ++i)
+    {
+        median.insert(data[i]);
+        median.erase(data[i - window]);
+        out[i - window + 1] = median.median();
+    }
+}
+
+// --------------------
+// KLL sketch: mergeable approximate quantiles in O(k) memory
+// --------------------
+
+/**
+ * @brief KLL quantile sketch (Karnin, Lang, Liberty)
+ *
+ * Level h holds items of weight 2^h. When the sketch outgrows its capacity, the
+ * lowest level over its own capacity k * (2/3)^(depth - h) is sorted and every
+ * other item (starting at a random offset) is promoted to level h + 1, the rest
+ * is dropped. About 3k items are retained, updates cost O(log k) amortized (the
+ * sort of level 0 every ~k updates) and the rank error is O(n / k) with high
+ * probability, e.g. within 1.5% of n for k = 200.
+ *
+ * Sketches with the same k merge by concatenating levels and compacting, so
+ * every thread can fill a private one and the owner merges them after joining,
+ * without any locking on the update path.
+ */
+class KllSketch
+{
+public:
+    explicit KllSketch(size_t k = 200, uint64_t seed = 47) : _k{ std::max<size_t>(k, 2) }, _gen{ seed }
+    {
+        grow();
+    }
+
+    uint64_t count() const { return _count; }
+    size_t   retained() const { return _retained; }
+    size_t   k() const { return _k; }
+
+    void update(int value)
+    {
+        _levels[0].push_back(value);
+        ++_count;
+        if (++_retained >= _maxRetained)
+            compress();
+    }
+
+    void merge(const KllSketch& other)
+    {
+        while (_levels.size() < other._levels.size())
+            grow();
+
+        for (size_t h = 0; h < other._levels.size(); ++h)
+            _levels[h].insert(_levels[h].end(), other._levels[h].begin(), other._levels[h].end());
+
+        _count += other._count;
+        _retained += other._retained;
+        while (_retained >= _maxRetained)
+            compress();
+    }
+
+    /**
+     * @brief estimated number of values <= @p value
+     */
+    uint64_t rank(int value) const
+    {
+        uint64_t result = 0;
+        for (size_t h = 0; h < _levels.size(); ++h)
+        {
+            for (const auto item : _levels[h])
+                result += item <= value ? uint64_t{ 1 } << h : 0;
+        }
+        return result;
+    }
+
+    /**
+     * @brief estimated element at rank max(1, ceil(q * count())) (as in
+     * weightedQuantile1), the sketch must not be empty
+     */
+    int quantile(double q) const
+    {
+        std::vector<std::pair<int, uint64_t>> items;
+        items.reserve(_retained);
+        for (size_t h = 0; h < _levels.size(); ++h)
+        {
+            for (const auto item : _levels[h])
+                items.emplace_back(item, uint64_t{ 1 } << h);
+        }
+        std::sort(items.begin(), items.end());
+
+        uint64_t total = 0;
+        for (const auto& item : items)
+            total += item.second;
+
+        const auto target = std::clamp<uint64_t>(
+            static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))), 1, total);
+
+        uint64_t cumulative = 0;
+        for (const auto& [value, weight] : items)
+        {
+            cumulative += weight;
+            if (cumulative >= target)
+                return value;
+        }
+        return items.back().first;
+    }
+
+private:
+    // capacities only change when a level is added, so they are cached
+    void grow()
+    {
+        _levels.emplace_back();
+        _capacities.resize(_levels.size());
+        _maxRetained = 0;
+        for (size_t h = 0; h < _levels.size(); ++h)
+        {
+            const auto depth = static_cast<double>(_levels.size() - h - 1);
+            _capacities[h] = static_cast<size_t>(std::ceil(_k * std::pow(2.0 / 3.0, depth))) + 1;
+            _maxRetained += _capacities[h];
+        }
+    }
+
+    // compacts the lowest level that is over its capacity
+    void compress()
+    {
+        for (size_t h = 0; h < _levels.size(); ++h)
+        {
+            if (_levels[h].size() < _capacities[h])
+                continue;
+            if (h + 1 == _levels.size())
+                grow();
+
+            auto& level = _levels[h];
+            std::sort(level.begin(), level.end());
+
+            // an odd item out stays on this level with its weight
+            const size_t keep   = level.size() % 2;
+            const size_t offset = keep + (_gen() & 1);
+            for (size_t i = offset; i < level.size(); i += 2)
+                _levels[h + 1].push_back(level[i]);
+
+            _retained -= level.size() - keep - (level.size() - keep) / 2;
+            level.resize(keep);
+            return;
+        }
+    }
+
+    size_t                        _k;
+    std::mt19937_64               _gen;
+    std::vector<std::vector<int>> _levels;
+    std::vector<size_t>           _capacities;
+    uint64_t                      _count       = 0;
+    size_t                        _retained    = 0;
+    size_t                        _maxRetained = 0;
+};
+
+/**
+ * @brief sketch of data[0..size): each of @p threads threads fills a private
+ * KllSketch from its chunk, the thread-local sketches are merged afterwards
+ */
+KllSketch parallelKllSketch1(const int *data, size_t size, size_t threads, size_t k)
+{
+    threads = std::max<size_t>(threads, 1);
+
+    std::vector<KllSketch> sketches;
+    sketches.reserve(threads);
+    for (size_t t = 0; t < threads; ++t)
+        sketches.emplace_back(k, 47 + t);
+
+    parallelFor(
+        threads,
+        [&](size_t t)
+        {
+            for (size_t i = size * t / threads; i < size * (t + 1) / threads; ++i)
+                sketches[t].update(data[i]);
+        });
+
+    for (size_t t = 1; t < threads; ++t)
+        sketches[0].merge(sketches[t]);
+    return std::move(sketches[0]);
+}
+
+// --------------------
+// HDR histogram: log-bucketed counts with bounded relative error
+// --------------------
+
+/**
+ * @brief histogram of non-negative int values (e.g. latencies) with 2^Bits
+ * linear sub-buckets per power of two
+ *
+ * Values below 2^Bits have a bucket each; a larger value v with
+ * bit_width(v) = Bits + m lands in a bucket 2^m wide, (m << (Bits - 1)) +
+ * (v >> m) being its index. Recording is a bit_width and an increment of a
+ * flat, cache-line aligned array of counts, and quantiles are answered with a
+ * relative error of at most 2^-Bits (exactly below 2^Bits).
+ */
+template <int Bits = 7>
+class HdrHistogram
+{
+    static_assert(Bits >= 1 && Bits <= 24, "HdrHistogram: Bits should be in [1, 24]");
+
+public:
+    static constexpr size_t kBuckets = size_t{ 33 - Bits } << (Bits - 1);
+
+    static size_t bucketIndex(int value)
+    {
+        const auto   v = static_cast<uint32_t>(value);
+        const size_t m = std::max(static_cast<int>(std::bit_width(v)), Bits) - Bits;
+        return (m << (Bits - 1)) + (v >> m);
+    }
+
+    static int bucketLowest(size_t index)
+    {
+        const size_t m = std::max<size_t>(index >> (Bits - 1), 1) - 1;
+        return static_cast<int>((index - (m << (Bits - 1))) << m);
+    }
+
+    static int bucketWidth(size_t index)
+    {
+        return 1 << (std::max<size_t>(index >> (Bits - 1), 1) - 1);
+    }
+
+    /**
+     * @brief records @p count occurrences of @p value; throws on a negative value
+     */
+    void record(int value, uint64_t count = 1)
+    {
+        if (value < 0)
+            throw std::runtime_error{ "HdrHistogram: values should be non-negative" };
+        _counts[bucketIndex(value)] += count;
+        _total += count;
+    }
+
+    uint64_t count() const { return _total; }
+
+    void merge(const HdrHistogram& other)
+    {
+        for (size_t i = 0; i < kBuckets; ++i)
+            _counts[i] += other._counts[i];
+        _total += other._total;
+    }
+
+    /**
+     * @brief value at rank max(1, ceil(q * count())) (as in weightedQuantile1),
+     * reported as the middle of its bucket; the histogram must not be empty
+     */
+    int quantile(double q) const
+    {
+        const auto target = std::clamp<uint64_t>(
+            static_cast<uint64_t>(std::ceil(q * static_cast<double>(_total))), 1, _total);
+
+        uint64_t cumulative = 0;
+        size_t   i          = 0;
+        while (cumulative + _counts[i] < target)
+            cumulative += _counts[i++];
+
+        return bucketLowest(i) + bucketWidth(i) / 2;
+    }
+
+    /**
+     * @brief compact binary form: LEB128 varints of Bits, the number of
+     * non-empty buckets and (index gap, count) for each of them
+     */
+    std::vector<uint8_t> serialize() const
+    {
+        std::vector<uint8_t> bytes;
+        auto                 put = [&](uint64_t x)
+        {
+            for (; x >= 0x80; x >>= 7)
+                bytes.push_back(static_cast<uint8_t>(x | 0x80));
+            bytes.push_back(static_cast<uint8_t>(x));
+        };
+
+        const auto used = std::count_if(
+            _counts.begin(), _counts.end(), [](uint64_t c) { return c != 0; });
+
+        put(Bits);
+        put(used);
+        size_t previous = 0;
+        for (size_t i = 0; i < kBuckets; ++i)
+        {
+            if (_counts[i] == 0)
+                continue;
+            put(i - previous);
+            put(_counts[i]);
+            previous = i;
+        }
+        return bytes;
+    }
+
+    static HdrHistogram deserialize(const std::vector<uint8_t>& bytes)
+    {
+        size_t pos = 0;
+        auto   get = [&]()
+        {
+            uint64_t x     = 0;
+            int      shift = 0;
+            while (true)
+            {
+                if (pos == bytes.size() || shift > 63)
+                    throw std::runtime_error{ "HdrHistogram: truncated or corrupted data" };
+                const uint8_t byte = bytes[pos++];
+                x |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (byte < 0x80)
+                    return x;
+                shift += 7;
+            }
+        };
+
+        if (get() != Bits)
+            throw std::runtime_error{ "HdrHistogram: data was written with different Bits" };
+
+        HdrHistogram result;
+        const auto   used  = get();
+        size_t       index = 0;
+        for (uint64_t i = 0; i < used; ++i)
+        {
+            const uint64_t gap = get();
+            if (i > 0 && gap == 0)
+                throw std::runtime_error{ "HdrHistogram: bucket indices should increase" };
+            if (gap >= kBuckets - index)
+                throw std::runtime_error{ "HdrHistogram: bucket index out of range" };
+            index += gap;
+
+            const uint64_t count = get();
+            if (count == 0 || count > std::numeric_limits<uint64_t>::max() - result._total)
+                throw std::runtime_error{ "HdrHistogram: truncated or corrupted data" };
+            result._counts[index] = count;
+            result._total += count;
+        }
+        if (pos != bytes.size())
+            throw std::runtime_error{ "HdrHistogram: trailing bytes after the data" };
+        return result;
+    }
+
+private:
+    alignas(64) std::array<uint64_t, kBuckets> _counts{};
+    uint64_t _total = 0;
+};
+
+// --------------------
+// Robust statistics from one multiselect pass
+// --------------------
+
+/**
+ * @brief location and spread estimates that tolerate outliers, see robustStats1
+ */
+struct RobustStats
+{
+    double median;
+    double mad;               // median absolute deviation from the median
+    int    lowerQuartile;     // element at rank ceil(n / 4)
+    int    upperQuartile;     // element at rank ceil(3n / 4)
+    double interquartileRange;
+    double trimmedMean;       // mean of the elements left after cutting floor(trim * n) from each end
+    double winsorizedMean;    // mean after clamping those elements to the nearest kept one
+};
+
+/**
+ * @brief all of RobustStats for @p v with one multiSelectRange call
+ *
+ * The call selects both middle elements, both quartiles and the two trimming
+ * bounds together, and leaves @p v partitioned at all of them, so the trimmed
+ * and winsorized sums are a single pass over the middle segment. MAD needs the
+ * median first; it is one more pass for the doubled deviations |2x - (a + b)|
+ * into @p scratch and one selection there with @p pivotFunction. The doubled
+ * deviations all have the parity of a + b and are below 2^33, so
+ * floor(deviation / 2) + INT_MIN keeps their order and fits in int.
+ *
+ * @p trim is in [0, 0.5) and @p v is not empty; @p v is reordered.
+ */
+RobustStats robustStats1(std::vector<int>& v, double trim, Pivot_f pivotFunction, std::vector<int>& scratch)
+{
+    const int n    = v.size();
+    const int g    = std::min(static_cast<int>(trim * n), (n - 1) / 2);
+    const int low  = g;
+    const int high = n - 1 - g;
+
+    const int lowerQuartile = std::max(static_cast<int>(std::ceil(n / 4.0)), 1) - 1;
+    const int upperQuartile = std::max(static_cast<int>(std::ceil(3 * n / 4.0)), 1) - 1;
+
+    std::vector<int> ranks{ low, high, lowerQuartile, upperQuartile, (n - 1) / 2, n / 2 };
+    std::sort(ranks.begin(), ranks.end());
+    std::vector<int> values(ranks.size());
+    multiSelectRange(v, 0, n - 1, ranks.data(), ranks.size(), values.data(), pivotFunction);
+
+    RobustStats res;
+
+    const long long a = v[(n - 1) / 2];
+    const long long b = v[n / 2];
+    res.median        = (a + b) / 2.0;
+
+    res.lowerQuartile      = v[lowerQuartile];
+    res.upperQuartile      = v[upperQuartile];
+    res.interquartileRange = static_cast<double>(res.upperQuartile) - res.lowerQuartile;
+
+    long long middle = 0;
+    for (int i = low; i <= high; ++i)
+        middle += v[i];
+    res.trimmedMean    = static_cast<double>(middle) / (high - low + 1);
+    res.winsorizedMean = (static_cast<double>(middle) + static_cast<double>(g) * v[low] +
+                          static_cast<double>(g) * v[high]) /
+                         n;
+
+    const long long parity = (a + b) & 1;
+    const auto      toKey  = [](long long deviation)
+    { return static_cast<int>(deviation / 2 + std::numeric_limits<int>::min()); };
+    const auto fromKey = [&](int key)
+    { return 2 * (static_cast<long long>(key) - std::numeric_limits<int>::min()) + parity; };
+
+    scratch.resize(n);
+    for (int i = 0; i < n; ++i)
+        scratch[i] = toKey(std::abs(2LL * v[i] - (a + b)));
+
+    const long long lower = fromKey(
+        scratch[introSelectRange(scratch.data(), n, (n - 1) / 2, pivotFunction)]);
+    const long long upper =
+        n % 2 == 1 ? lower : fromKey(*std::min_element(scratch.begin() + n / 2, scratch.begin() + n));
+    res.mad = (lower + upper) / 4.0;
+
+    return res;
+}
+
+// --------------------
+// 2D median filter: sorting networks, Huang and Perreault-Hebert histograms
+// --------------------
+
+enum class MedianFilterMethod
+{
+    Auto,               // Network for radius 1 and 2, ColumnHistogram for <= 256 distinct values, else Huang
+    Network,            // radius 1 or 2 only
+    Huang,
+    ColumnHistogram,    // <= 256 distinct values only
+};
+
+// output pixels of a row filtered together by the sorting networks
+constexpr size_t kMedianFilterLanes = 16;
+
+/**
+ * @brief compare-exchange pairs (lo, hi) applied in order by the networks below
+ */
+struct ComparatorNetwork
+{
+    std::array<std::pair<uint8_t, uint8_t>, 256> pairs{};
+    size_t                                       size = 0;
+};
+
+/**
+ * @brief network sorting N wires: Batcher's odd-even merge sort for the next
+ * power of two without the comparators touching wires >= N (they would only
+ * move +inf padding)
+ */
+template <size_t N>
+constexpr ComparatorNetwork sortingNetwork()
+{
+    static_assert(N <= 32, "sortingNetwork: N should be at most 32");
+
+    ComparatorNetwork sorting;
+    const size_t      n = std::bit_ceil(N);
+    for (size_t p = 1; p < n; p += p)
+    {
+        for (size_t k = p; k >= 1; k /= 2)
+        {
+            for (size_t j = k % p; j + k < n; j += 2 * k)
+            {
+                for (size_t i = 0; i < k && i + j + k < n; ++i)
+                {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < N)
+                        sorting.pairs[sorting.size++] = { static_cast<uint8_t>(i + j), static_cast<uint8_t>(i + j + k) };
+                }
+            }
+        }
+    }
+    return sorting;
+}
+
+/**
+ * @brief network leaving the median of N wires on wire N / 2: sortingNetwork
+ * without the comparators the median wire does not depend on, 24 pairs remain
+ * for 3x3, 113 for 5x5
+ */
+template <size_t N>
+constexpr ComparatorNetwork medianNetwork()
+{
+    static_assert(N % 2 == 1, "medianNetwork: N should be odd");
+
+    const auto        sorting = sortingNetwork<N>();
+    ComparatorNetwork pruned;
+    std::array<bool, N> needed{};
+    needed[N / 2] = true;
+    for (size_t i = sorting.size; i-- > 0;)
+    {
+        const auto [lo, hi] = sorting.pairs[i];
+        if (needed[lo] || needed[hi])
+        {
+            needed[lo] = needed[hi]  = true;
+            pruned.pairs[pruned.size++] = sorting.pairs[i];
+        }
+    }
+    for (size_t i = 0; i < pruned.size / 2; ++i)
+        std::swap(pruned.pairs[i], pruned.pairs[pruned.size - 1 - i]);
+    return pruned;
+}
+
+// @p i clamped to [0, n), pixels outside the image replicate the nearest edge one
+inline size_t clampIndex(long long i, size_t n)
+{
+    return static_cast<size_t>(std::clamp<long long>(i, 0, static_cast<long long>(n) - 1));
+}
+
+/**
+ * @brief rows [rowBegin, rowEnd) of the (2R + 1)^2 median filter with a
+ * median network run on kMedianFilterLanes neighbouring pixels at once: every
+ * compare-exchange is a min and a max over the lanes, which vectorizes
+ */
+template <size_t R>
+void medianFilterNetworkRows(const int *data, size_t rows, size_t cols, int *out, size_t rowBegin, size_t rowEnd)
+{
+    constexpr size_t        W       = 2 * R + 1;
+    static constexpr auto   network = medianNetwork<W * W>();
+    alignas(64) int         wires[W * W][kMedianFilterLanes];
+
+    for (size_t y = rowBegin; y < rowEnd; ++y)
+    {
+        for (size_t x0 = 0; x0 < cols; x0 += kMedianFilterLanes)
+        {
+            const bool interior = x0 >= R && x0 + kMedianFilterLanes + R <= cols;
+            for (size_t dy = 0; dy < W; ++dy)
+            {
+                const int *row = data + clampIndex(static_cast<long long>(y + dy) - R, rows) * cols;
+                for (size_t dx = 0; dx < W; ++dx)
+                {
+                    int *wire = wires[dy * W + dx];
+                    if (interior)
+                    {
+                        std::copy_n(row + x0 + dx - R, kMedianFilterLanes, wire);
+                        continue;
+                    }
+                    for (size_t lane = 0; lane < kMedianFilterLanes; ++lane)
+                        wire[lane] = row[clampIndex(static_cast<long long>(x0 + lane + dx) - R, cols)];
+                }
+            }
+
+            for (size_t i = 0; i < network.size; ++i)
+            {
+                int *lo = wires[network.pairs[i].first];
+                int *hi = wires[network.pairs[i].second];
+
+                // local copies: the compiler cannot prove lo and hi apart,
+                // without them it neither vectorizes nor avoids branches
+                std::array<int, kMedianFilterLanes> a;
+                std::array<int, kMedianFilterLanes> b;
+                std::copy_n(lo, kMedianFilterLanes, a.begin());
+                std::copy_n(hi, kMedianFilterLanes, b.begin());
+                for (size_t lane = 0; lane < kMedianFilterLanes; ++lane)
+                    lo[lane] = std::min(a[lane], b[lane]);
+                for (size_t lane = 0; lane < kMedianFilterLanes; ++lane)
+                    hi[lane] = std::max(a[lane], b[lane]);
+            }
+
+            std::copy_n(wires[W * W / 2], std::min(kMedianFilterLanes, cols - x0), out + y * cols + x0);
+        }
+    }
+}
+
+/**
+ * @brief pixels replaced by dense ranks of their values, so the histogram
+ * filters need one bin per distinct value: values[bins[i]] == data[i]
+ */
+struct BinnedImage
+{
+    std::vector<uint32_t> bins;
+    std::vector<int>      values;
+};
+
+BinnedImage binImage(const int *data, size_t size)
+{
+    BinnedImage res;
+    res.bins.resize(size);
+
+    const auto [lo, hi] = std::minmax_element(data, data + size);
+    const long long range = static_cast<long long>(*hi) - *lo + 1;
+
+    // narrow range: mark the values present and number them in one pass each
+    if (range <= (1 << 20))
+    {
+        std::vector<uint32_t> rank(range, 0);
+        for (size_t i = 0; i < size; ++i)
+            rank[data[i] - *lo] = 1;
+        uint32_t next = 0;
+        for (long long v = 0; v < range; ++v)
+        {
+            if (rank[v] != 0)
+            {
+                rank[v] = next++;
+                res.values.push_back(static_cast<int>(*lo + v));
+            }
+        }
+        for (size_t i = 0; i < size; ++i)
+            res.bins[i] = rank[data[i] - *lo];
+        return res;
+    }
+
+    res.values.assign(data, data + size);
+    std::sort(res.values.begin(), res.values.end());
+    res.values.erase(std::unique(res.values.begin(), res.values.end()), res.values.end());
+    for (size_t i = 0; i < size; ++i)
+        res.bins[i] = std::lower_bound(res.values.begin(), res.values.end(), data[i]) - res.values.begin();
+    return res;
+}
+
+// fine bins per coarse bin of the Huang window histogram
+constexpr size_t kHuangCoarseBits = 6;
+
+/**
+ * @brief rows [rowBegin, rowEnd) of the median filter of @p radius with
+ * Huang's sliding window histogram
+ *
+ * Moving one pixel right removes a column of 2r + 1 bins and adds another, so
+ * a pixel costs O(r). The median bin is tracked with the number of values
+ * below it and only moves by the change of the window, using the coarse
+ * counts (2^kHuangCoarseBits bins each) to skip over empty ranges.
+ */
+void medianFilterHuangRows(
+    const BinnedImage &image, size_t rows, size_t cols, size_t radius, int *out, size_t rowBegin, size_t rowEnd)
+{
+    const size_t binCount = image.values.size();
+    const size_t target   = (2 * radius + 1) * (2 * radius + 1) / 2;
+    const long long r     = static_cast<long long>(radius);
+
+    std::vector<uint32_t> fine(binCount, 0);
+    std::vector<uint32_t> coarse((binCount >> kHuangCoarseBits) + 1, 0);
+    size_t                median = 0;
+    size_t                below  = 0;
+
+    const auto column = [&](long long y, long long x, int sign)
+    {
+        const size_t c = clampIndex(x, cols);
+        for (long long dy = -r; dy <= r; ++dy)
+        {
+            const uint32_t bin = image.bins[clampIndex(y + dy, rows) * cols + c];
+            fine[bin] += sign;
+            coarse[bin >> kHuangCoarseBits] += sign;
+            if (bin < median)
+                below += sign;
+        }
+    };
+
+    const auto settle = [&]()
+    {
+        constexpr size_t kCoarse = size_t{ 1 } << kHuangCoarseBits;
+        while (below > target)
+        {
+            const size_t block = median >> kHuangCoarseBits;
+            if (median % kCoarse == 0 && below - coarse[block - 1] > target)
+            {
+                below -= coarse[block - 1];
+                median -= kCoarse;
+                continue;
+            }
+            below -= fine[--median];
+        }
+        while (below + fine[median] <= target)
+        {
+            const size_t block = median >> kHuangCoarseBits;
+            if (median % kCoarse == 0 && below + coarse[block] <= target)
+            {
+                below += coarse[block];
+                median += kCoarse;
+                continue;
+            }
+            below += fine[median++];
+        }
+    };
+
+    for (size_t y = rowBegin; y < rowEnd; ++y)
+    {
+        for (long long dx = -r; dx <= r; ++dx)
+            column(y, dx, 1);
+        settle();
+        out[y * cols] = image.values[median];
+
+        for (size_t x = 1; x < cols; ++x)
+        {
+            column(y, static_cast<long long>(x) + r, 1);
+            column(y, static_cast<long long>(x) - r - 1, -1);
+            settle();
+            out[y * cols + x] = image.values[median];
+        }
+
+        for (long long dx = -r; dx <= r; ++dx)
+            column(y, static_cast<long long>(cols) - 1 + dx, -1);
+        median = below = 0;
+    }
+}
+
+/**
+ * @brief rows [rowBegin, rowEnd) of the median filter of @p radius for images
+ * with at most 256 distinct values, with Perreault and Hebert's column
+ * histograms: O(1) per pixel regardless of the radius
+ *
+ * Every column keeps a 16 x 16 bins histogram of its 2r + 1 pixels around the
+ * current row, updated with one removal and one addition per row. The window
+ * coarse histogram (16 bins) adds one column's and subtracts another's per
+ * pixel; the fine histogram of a coarse bin is only brought up to date when
+ * the median falls into it, from wherever it was last used, or rebuilt from
+ * the 2r + 1 columns if that is cheaper.
+ */
+void medianFilterColumnRows(
+    const BinnedImage &image, size_t rows, size_t cols, size_t radius, int *out, size_t rowBegin, size_t rowEnd)
+{
+    constexpr size_t kBins = 256;
+    constexpr size_t kSide = 16;
+
+    const size_t    target = (2 * radius + 1) * (2 * radius + 1) / 2;
+    const long long r      = static_cast<long long>(radius);
+
+    std::vector<uint32_t> columnFine(cols * kBins, 0);
+    std::vector<uint32_t> columnCoarse(cols * kSide, 0);
+
+    const auto columnPixel = [&](size_t y, size_t x, int sign)
+    {
+        const uint32_t bin = image.bins[y * cols + x];
+        columnFine[x * kBins + bin] += sign;
+        columnCoarse[x * kSide + bin / kSide] += sign;
+    };
+
+    for (size_t x = 0; x < cols; ++x)
+    {
+        for (long long dy = -r; dy <= r; ++dy)
+            columnPixel(clampIndex(static_cast<long long>(rowBegin) + dy, rows), x, 1);
+    }
+
+    std::array<uint32_t, kSide>                       coarse;
+    std::array<std::array<uint32_t, kSide>, kSide>    fine;
+    std::array<long long, kSide>                      fineAt;
+
+    for (size_t y = rowBegin; y < rowEnd; ++y)
+    {
+        if (y > rowBegin)
+        {
+            const size_t removed = clampIndex(static_cast<long long>(y) - r - 1, rows);
+            const size_t added   = clampIndex(static_cast<long long>(y) + r, rows);
+            for (size_t x = 0; x < cols; ++x)
+            {
+                columnPixel(removed, x, -1);
+                columnPixel(added, x, 1);
+            }
+        }
+
+        coarse.fill(0);
+        fineAt.fill(-2 * r - 2);    // stale: rebuilt on first use
+        for (long long dx = -r; dx <= r; ++dx)
+        {
+            const uint32_t *column = &columnCoarse[clampIndex(dx, cols) * kSide];
+            for (size_t c = 0; c < kSide; ++c)
+                coarse[c] += column[c];
+        }
+
+        for (long long x = 0; x < static_cast<long long>(cols); ++x)
+        {
+            if (x > 0)
+            {
+                const uint32_t *added   = &columnCoarse[clampIndex(x + r, cols) * kSide];
+                const uint32_t *removed = &columnCoarse[clampIndex(x - r - 1, cols) * kSide];
+                for (size_t c = 0; c < kSide; ++c)
+                    coarse[c] += added[c] - removed[c];
+            }
+
+            size_t below = 0;
+            size_t c     = 0;
+            while (below + coarse[c] <= target)
+                below += coarse[c++];
+
+            auto &bucket = fine[c];
+            if (x - fineAt[c] > r + 1)
+            {
+                bucket.fill(0);
+                for (long long dx = -r; dx <= r; ++dx)
+                {
+                    const uint32_t *column = &columnFine[clampIndex(x + dx, cols) * kBins + c * kSide];
+                    for (size_t b = 0; b < kSide; ++b)
+                        bucket[b] += column[b];
+                }
+            }
+            else
+            {
+                for (long long xx = fineAt[c] + 1; xx <= x; ++xx)
+                {
+                    const uint32_t *added   = &columnFine[clampIndex(xx + r, cols) * kBins + c * kSide];
+                    const uint32_t *removed = &columnFine[clampIndex(xx - r - 1, cols) * kBins + c * kSide];
+                    for (size_t b = 0; b < kSide; ++b)
+                        bucket[b] += added[b] - removed[b];
+                }
+            }
+            fineAt[c] = x;
+
+            size_t b = 0;
+            while (below + bucket[b] <= target)
+                below += bucket[b++];
+            out[y * cols + x] = image.values[c * kSide + b];
+        }
+    }
+}
+
+/**
+ * @brief median of the (2 * radius + 1)^2 window around every pixel of the
+ * @p rows x @p cols row-major image @p data into @p out, pixels outside the
+ * image replicate the nearest edge pixel
+ *
+ * Rows are split into @p threads bands filtered independently (each with its
+ * own histograms), see MedianFilterMethod for the algorithms.
+ */
+void medianFilter2D1(
+    const int         *data,
+    size_t             rows,
+    size_t             cols,
+    size_t             radius,
+    int               *out,
+    size_t             threads,
+    MedianFilterMethod method = MedianFilterMethod::Auto)
+{
+    if (rows == 0 || cols == 0)
+        return;
+
+    if (method == MedianFilterMethod::Network && radius != 1 && radius != 2)
+        throw std::runtime_error{ "medianFilter2D1: median networks are only built for radius 1 and 2" };
+
+    if (method == MedianFilterMethod::Auto && radius == 0)
+    {
+        std::copy_n(data, rows * cols, out);
+        return;
+    }
+
+    BinnedImage image;
+    const bool  network = method == MedianFilterMethod::Network ||
+                         (method == MedianFilterMethod::Auto && (radius == 1 || radius == 2));
+    if (!network)
+    {
+        image = binImage(data, rows * cols);
+        if (method == MedianFilterMethod::Auto)
+            method = image.values.size() <= 256 ? MedianFilterMethod::ColumnHistogram : MedianFilterMethod::Huang;
+        if (method == MedianFilterMethod::ColumnHistogram && image.values.size() > 256)
+            throw std::runtime_error{ "medianFilter2D1: column histograms need at most 256 distinct values" };
+    }
+
+    threads = std::clamp<size_t>(threads, 1, rows);
+    parallelFor(
+        threads,
+        [&](size_t t)
+        {
+            const size_t begin = rows * t / threads;
+            const size_t end   = rows * (t + 1) / threads;
+            if (network)
+            {
+                if (radius == 1)
+                    medianFilterNetworkRows<1>(data, rows, cols, out, begin, end);
+                else
+                    medianFilterNetworkRows<2>(data, rows, cols, out, begin, end);
+            }
+            else if (method == MedianFilterMethod::Huang)
+            {
+                medianFilterHuangRows(image, rows, cols, radius, out, begin, end);
+            }
+            else
+            {
+                medianFilterColumnRows(image, rows, cols, radius, out, begin, end);
+            }
+        });
+}
+
+// --------------------
+// Grouped (segmented) selection: one quantile per group of a flat array
+// --------------------
+
+// groups up to this size are sorted by a network instead of selected in
+constexpr size_t kGroupedSortCutoff = 16;
+// consecutive groups are handed to threads in units of about this many
+// elements, a larger group is a unit on its own
+constexpr size_t kGroupedChunk = size_t{ 1 } << 14;
+// groups at least this large are selected in by all threads together
+constexpr size_t kGroupedParallelCutoff = size_t{ 1 } << 17;
+
+void sortSmallGroups(int *values, const size_t *offsets, const size_t *groups, size_t count);
+
+/**
+ * @brief calls fn(data, size, g, threads) for every group g, data[0..size)
+ * being values[offsets[g]..offsets[g + 1]), on @p threads threads
+ *
+ * Threads take chunks of consecutive groups from a shared cursor, so a few
+ * large groups next to many small ones still keep all threads busy. Groups of
+ * at most kGroupedSortCutoff elements are passed to fn already sorted, those
+ * of equal size within a chunk up to kMedianFilterLanes at a time by one
+ * network (see sortSmallGroups). With @p threads > 1, groups of at least
+ * kGroupedParallelCutoff elements are left out of the chunks and passed to fn
+ * one at a time afterwards with all @p threads; fn gets 1 for the others.
+ */
+template <typename F>
+void forEachGroup(int *values, const size_t *offsets, size_t groups, size_t threads, F fn)
+{
+    for (size_t g = 0; g < groups; ++g)
+    {
+        if (offsets[g + 1] <= offsets[g])
+            throw std::runtime_error{ "forEachGroup: groups should be non-empty and offsets increasing" };
+    }
+
+    if (groups == 0)
+        return;
+
+    threads          = std::max<size_t>(threads, 1);
+    const auto sizeOf = [&](size_t g) { return offsets[g + 1] - offsets[g]; };
+    const auto wide   = [&](size_t g) { return threads > 1 && sizeOf(g) >= kGroupedParallelCutoff; };
+
+    std::vector<size_t> chunks{ 0 };
+    for (size_t g = 0; g < groups; ++g)
+    {
+        // a large group closes the pending chunk of smaller ones before it
+        if (sizeOf(g) >= kGroupedChunk && chunks.back() != g)
+            chunks.push_back(g);
+        if (offsets[g + 1] - offsets[chunks.back()] >= kGroupedChunk)
+            chunks.push_back(g + 1);
+    }
+    if (chunks.back() != groups)
+        chunks.push_back(groups);
+
+    std::atomic<size_t> next{ 0 };
+    parallelFor(
+        std::min(threads, chunks.size() - 1),
+        [&](size_t)
+        {
+            for (size_t c = next++; c + 1 < chunks.size(); c = next++)
+            {
+                // small groups of equal size wait here until a full batch
+                std::array<std::array<size_t, kMedianFilterLanes>, kGroupedSortCutoff + 1> pending;
+                std::array<size_t, kGroupedSortCutoff + 1>                                 waiting{};
+                const auto flush = [&](size_t size)
+                {
+                    sortSmallGroups(values, offsets, pending[size].data(), waiting[size]);
+                    for (size_t i = 0; i < waiting[size]; ++i)
+                        fn(values + offsets[pending[size][i]], size, pending[size][i], size_t{ 1 });
+                    waiting[size] = 0;
+                };
+
+                for (size_t g = chunks[c]; g < chunks[c + 1]; ++g)
+                {
+                    const size_t size = sizeOf(g);
+                    if (size <= kGroupedSortCutoff)
+                    {
+                        pending[size][waiting[size]++] = g;
+                        if (waiting[size] == kMedianFilterLanes)
+                            flush(size);
+                    }
+                    // wide groups are chunks of their own, done below
+                    else if (!wide(g))
+                        fn(values + offsets[g], size, g, size_t{ 1 });
+                }
+                for (size_t size = 1; size <= kGroupedSortCutoff; ++size)
+                {
+                    if (waiting[size] > 0)
+                        flush(size);
+                }
+            }
+        });
+
+    for (size_t g = 0; g < groups; ++g)
+    {
+        if (wide(g))
+            fn(values + offsets[g], sizeOf(g), g, threads);
+    }
+}
+
+template <size_t N>
+constexpr auto kSortingNetwork = sortingNetwork<N>();
+
+template <size_t N, size_t... I>
+void networkSortUnrolled(int *data, std::index_sequence<I...>)
+{
+    std::array<int, N> w;
+    std::copy_n(data, N, w.begin());
+    (
+        [&w]
+        {
+            constexpr auto lo = kSortingNetwork<N>.pairs[I].first;
+            constexpr auto hi = kSortingNetwork<N>.pairs[I].second;
+            const int      a  = w[lo];
+            const int      b  = w[hi];
+            w[lo]             = std::min(a, b);
+            w[hi]             = std::max(a, b);
+        }(),
+        ...);
+    std::copy_n(w.begin(), N, data);
+}
+
+/**
+ * @brief sorts data[0..N) with sortingNetwork<N>, unrolled and branch-free:
+ * the wires stay in registers and the compare-exchanges compile to
+ * conditional moves, so random data costs no mispredictions, unlike
+ * insertion sort
+ */
+template <size_t N>
+void networkSort(int *data)
+{
+    networkSortUnrolled<N>(data, std::make_index_sequence<kSortingNetwork<N>.size>{});
+}
+
+template <size_t... N>
+constexpr auto makeNetworkSorts(std::index_sequence<N...>)
+{
+    return std::array<void (*)(int *), sizeof...(N)>{ &networkSort<N>... };
+}
+
+// kSmallGroupSorts[n] sorts n elements
+constexpr auto kSmallGroupSorts = makeNetworkSorts(std::make_index_sequence<kGroupedSortCutoff + 1>{});
+
+template <size_t... N>
+constexpr auto makeSortingNetworks(std::index_sequence<N...>)
+{
+    return std::array<ComparatorNetwork, sizeof...(N)>{ sortingNetwork<N>()... };
+}
+
+// kGroupNetworks[n] sorts n wires
+constexpr auto kGroupNetworks = makeSortingNetworks(std::make_index_sequence<kGroupedSortCutoff + 1>{});
+
+/**
+ * @brief sorts groups groups[0..count) (see forEachGroup), at most
+ * kMedianFilterLanes of them with at most kGroupedSortCutoff elements each
+ *
+ * A lone group gets its own network. Otherwise groups[j] is lane j of one
+ * network as wide as the largest group, run on all lanes at once as in
+ * medianFilterNetworkRows; missing wires are padded with INT_MAX, which sorts
+ * past the elements, so a group gets back its first size wires sorted.
+ */
+void sortSmallGroups(int *values, const size_t *offsets, const size_t *groups, size_t count)
+{
+    if (count == 1)
+    {
+        kSmallGroupSorts[offsets[groups[0] + 1] - offsets[groups[0]]](values + offsets[groups[0]]);
+        return;
+    }
+
+    size_t width = 0;
+    for (size_t lane = 0; lane < count; ++lane)
+        width = std::max(width, offsets[groups[lane] + 1] - offsets[groups[lane]]);
+
+    alignas(64) int wires[kGroupedSortCutoff][kMedianFilterLanes];
+    std::fill_n(&wires[0][0], width * kMedianFilterLanes, std::numeric_limits<int>::max());
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        const int *group = values + offsets[groups[lane]];
+        for (size_t w = 0; w < offsets[groups[lane] + 1] - offsets[groups[lane]]; ++w)
+            wires[w][lane] = group[w];
+    }
+
+    const auto &network = kGroupNetworks[width];
+    for (size_t i = 0; i < network.size; ++i)
+    {
+        int *lo = wires[network.pairs[i].first];
+        int *hi = wires[network.pairs[i].second];
+
+        // local copies, as in medianFilterNetworkRows
+        std::array<int, kMedianFilterLanes> a;
+        std::array<int, kMedianFilterLanes> b;
+        std::copy_n(lo, kMedianFilterLanes, a.begin());
+        std::copy_n(hi, kMedianFilterLanes, b.begin());
+        for (size_t lane = 0; lane < kMedianFilterLanes; ++lane)
+            lo[lane] = std::min(a[lane], b[lane]);
+        for (size_t lane = 0; lane < kMedianFilterLanes; ++lane)
+            hi[lane] = std::max(a[lane], b[lane]);
+    }
+
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        int *group = values + offsets[groups[lane]];
+        for (size_t w = 0; w < offsets[groups[lane] + 1] - offsets[groups[lane]]; ++w)
+            group[w] = wires[w][lane];
+    }
+}
+
+/**
+ * @brief groupSelect of one large group on @p threads threads: every round
+ * picks a random pivot from the window holding rank @p k, counts the elements
+ * less than / equal to it per thread chunk and scatters the window into
+ * @p buffer in three-way partitioned order at the prefix-summed offsets (as
+ * parallelQuickSelect1 does for one side), then copies it back in parallel,
+ * so the group itself ends up partitioned around rank k
+ */
+size_t groupSelectParallel(int *data, size_t size, size_t k, size_t threads)
+{
+    auto gen = std::mt19937{ static_cast<unsigned>(size) };
+
+    std::vector<int>    buffer(size);
+    std::vector<size_t> less(threads);
+    std::vector<size_t> equal(threads);
+
+    size_t left  = 0;
+    size_t right = size;
+    while (right - left > kParallelQuickSelectCutoff)
+    {
+        int *const   window = data + left;
+        const size_t active = right - left;
+        const int    pivotValue =
+            window[std::uniform_int_distribution<size_t>{ 0, active - 1 }(gen)];
+
+        const auto chunkBegin = [&](size_t t) { return active * t / threads; };
+
+        parallelFor(
+            threads,
+            [&](size_t t)
+            {
+                size_t lessCount  = 0;
+                size_t equalCount = 0;
+                for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+                {
+                    lessCount += window[i] < pivotValue;
+                    equalCount += window[i] == pivotValue;
+                }
+                less[t]  = lessCount;
+                equal[t] = equalCount;
+            });
+
+        size_t totalLess  = 0;
+        size_t totalEqual = 0;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            totalLess += less[t];
+            totalEqual += equal[t];
+        }
+
+        parallelFor(
+            threads,
+            [&](size_t t)
+            {
+                size_t lessBefore  = 0;
+                size_t equalBefore = 0;
+                for (size_t u = 0; u < t; ++u)
+                {
+                    lessBefore += less[u];
+                    equalBefore += equal[u];
+                }
+                // each thread writes only its own slices of the three parts
+                int *lessOut    = buffer.data() + lessBefore;
+                int *equalOut   = buffer.data() + totalLess + equalBefore;
+                int *greaterOut = buffer.data() + totalLess + totalEqual +
+                                  (chunkBegin(t) - lessBefore - equalBefore);
+                for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+                {
+                    const int value = window[i];
+                    if (value < pivotValue)
+                        *lessOut++ = value;
+                    else if (value == pivotValue)
+                        *equalOut++ = value;
+                    else
+                        *greaterOut++ = value;
+                }
+            });
+
+        parallelFor(
+            threads,
+            [&](size_t t)
+            { std::copy(buffer.begin() + chunkBegin(t), buffer.begin() + chunkBegin(t + 1), window + chunkBegin(t)); });
+
+        if (k < left + totalLess)
+            right = left + totalLess;
+        else if (k < left + totalLess + totalEqual)
+            return k;
+        else
+            left += totalLess + totalEqual;
+    }
+
+    std::nth_element(data + left, data + k, data + right);
+    return k;
+}
+
+/**
+ * @brief index of the 0-based @p k th element of data[0..size) after moving it
+ * there, for a group passed by forEachGroup with @p threads: small groups
+ * arrive sorted, groups given several threads are selected in by
+ * groupSelectParallel, the rest by std::nth_element (introselect, with a
+ * faster partition loop than introSelectRange)
+ */
+size_t groupSelect(int *data, size_t size, size_t k, size_t threads)
+{
+    if (size <= kGroupedSortCutoff)
+        return k;
+    if (threads > 1)
+        return groupSelectParallel(data, size, k, threads);
+    std::nth_element(data, data + k, data + size);
+    return k;
+}
+
+/**
+ * @brief out[g] = element at rank max(1, ceil(q * size)) of group g (see
+ * forEachGroup), every group is partitioned in place around it
+ */
+void groupedQuantiles1(int *values, const size_t *offsets, size_t groups, double q, size_t threads, int *out)
+{
+    forEachGroup(
+        values,
+        offsets,
+        groups,
+        threads,
+        [&](int *data, size_t size, size_t g, size_t groupThreads)
+        {
+            const auto rank = std::clamp<size_t>(static_cast<size_t>(std::ceil(q * size)), 1, size) - 1;
+            out[g]          = data[groupSelect(data, size, rank, groupThreads)];
+        });
+}
+
+/**
+ * @brief out[g] = median of group g (see forEachGroup), every group is
+ * partitioned in place around its lower median
+ */
+void groupedMedians1(int *values, const size_t *offsets, size_t groups, size_t threads, double *out)
+{
+    forEachGroup(
+        values,
+        offsets,
+        groups,
+        threads,
+        [&](int *data, size_t size, size_t g, size_t groupThreads)
+        {
+            const long long lower = data[groupSelect(data, size, (size - 1) / 2, groupThreads)];
+            const long long upper =
+                size % 2 == 1 ? lower : *std::min_element(data + size / 2, data + size);
+            out[g] = (lower + upper) / 2.0;
+        });
+}
+
+/**
+ * @brief reorders @p keys and @p values together so that equal keys are
+ * contiguous, in ascending key order
+ *
+ * Rows are packed as (key with flipped sign bit) << 32 | value and LSD radix
+ * sorted on the key half, 11 bits per pass: O(n) with sequential access, no
+ * hashing or comparison sort of the rows. Passes whose digit is the same for
+ * all rows (e.g. the high bits of small keys) are skipped.
+ *
+ * @return std::vector<int> - the distinct keys in ascending order; @p offsets
+ * is resized to their count + 1 and delimits their groups as in forEachGroup
+ */
+std::vector<int> groupByKey1(std::vector<int>& keys, std::vector<int>& values, std::vector<size_t>& offsets)
+{
+    constexpr int    kDigitBits = 11;
+    constexpr size_t kDigits    = size_t{ 1 } << kDigitBits;
+
+    const size_t          n = keys.size();
+    std::vector<uint64_t> rows(n);
+    std::vector<uint64_t> buffer(n);
+    for (size_t i = 0; i < n; ++i)
+        rows[i] = static_cast<uint64_t>(static_cast<uint32_t>(keys[i]) ^ 0x80000000u) << 32 | static_cast<uint32_t>(values[i]);
+
+    std::vector<size_t> counts(kDigits + 1);
+    for (int shift = 32; shift < 64; shift += kDigitBits)
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (const auto row : rows)
+            ++counts[((row >> shift) & (kDigits - 1)) + 1];
+        if (std::find(counts.begin(), counts.end(), n) != counts.end())
+            continue;
+        for (size_t d = 1; d < counts.size(); ++d)
+            counts[d] += counts[d - 1];
+        for (const auto row : rows)
+            buffer[counts[(row >> shift) & (kDigits - 1)]++] = row;
+        rows.swap(buffer);
+    }
+
+    std::vector<int> groupKeys;
+    offsets.assign(1, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        keys[i]   = static_cast<int>(static_cast<uint32_t>(rows[i] >> 32) ^ 0x80000000u);
+        values[i] = static_cast<int>(static_cast<uint32_t>(rows[i]));
+        if (i == 0 || keys[i] != keys[i - 1])
+        {
+            if (i > 0)
+                offsets.push_back(i);
+            groupKeys.push_back(keys[i]);
+        }
+    }
+    if (n > 0)
+        offsets.push_back(n);
+
+    return groupKeys;
+}
+
+// --------------------
+// Dynamic order statistics: kth and rank under inserts and erases
+// --------------------
+
+/**
+ * @brief multiset of ints with O(log n) insert, erase, kth and rank: a B+ tree
+ * whose internal nodes keep the element count of every child
+ *
+ * Nodes live in two pools (contiguous vectors, children referenced by 32-bit
+ * index) and keep their keys, counts and child indices in separate arrays, so
+ * a descent scans at most kFanout contiguous counts or low keys per level and
+ * leaves are sorted runs of up to kLeafCapacity ints. Full nodes are split in
+ * halves; a node that drops below a quarter of its capacity is merged with a
+ * neighbour when both fit into one node, and emptied nodes are recycled.
+ */
+class OrderStatisticTree
+{
+public:
+    static constexpr size_t kLeafCapacity = 64;
+    static constexpr size_t kFanout       = 32;
+
+    OrderStatisticTree() : OrderStatisticTree{ std::vector<int>{} } {}
+
+    // bulk load: sorts @p values and packs them into 3/4 full nodes
+    explicit OrderStatisticTree(std::vector<int> values)
+    {
+        std::sort(values.begin(), values.end());
+        _size = values.size();
+
+        std::vector<uint32_t> level;
+        constexpr size_t      kLeafFill = kLeafCapacity * 3 / 4;
+        for (size_t i = 0; i < values.size() || level.empty(); i += kLeafFill)
+        {
+            const uint32_t leaf = newLeaf();
+            const size_t   size = std::min(kLeafFill, values.size() - std::min(i, values.size()));
+            std::copy_n(values.begin() + i, size, _leaves[leaf].keys.begin());
+            _leaves[leaf].size = size;
+            level.push_back(leaf);
+        }
+
+        constexpr size_t kInternalFill = kFanout * 3 / 4;
+        while (level.size() > 1)
+        {
+            std::vector<uint32_t> parents;
+            for (size_t i = 0; i < level.size(); i += kInternalFill)
+            {
+                const uint32_t parent = newInternal();
+                auto          &node   = _internals[parent];
+                for (size_t j = i; j < std::min(i + kInternalFill, level.size()); ++j)
+                    append(node, level[j], _height);
+                parents.push_back(parent);
+            }
+            level.swap(parents);
+            ++_height;
+        }
+        _root = level.front();
+    }
+
+    size_t size() const { return _size; }
+
+    void insert(int value)
+    {
+        const uint32_t sibling = insertInto(_root, _height, value);
+        if (sibling != kNone)
+        {
+            const uint32_t root = newInternal();
+            append(_internals[root], _root, _height);
+            append(_internals[root], sibling, _height);
+            _root = root;
+            ++_height;
+        }
+        ++_size;
+    }
+
+    // removes one occurrence of @p value, false if there is none
+    bool erase(int value)
+    {
+        const size_t position = rank(value);
+        if (position == _size || kth(position + 1) != value)
+            return false;
+
+        eraseAt(_root, _height, position);
+        --_size;
+
+        if (_height > 0 && _internals[_root].size == 0)
+        {
+            _freeInternals.push_back(_root);
+            _root   = newLeaf();
+            _height = 0;
+        }
+        while (_height > 0 && _internals[_root].size == 1)
+        {
+            const uint32_t child = _internals[_root].children[0];
+            _freeInternals.push_back(_root);
+            _root = child;
+            --_height;
+        }
+        return true;
+    }
+
+    // 1-based @p k th smallest element, 1 <= k <= size()
+    int kth(size_t k) const
+    {
+        size_t   position = k - 1;
+        uint32_t node     = _root;
+        for (int level = _height; level > 0; --level)
+        {
+            const auto &internal = _internals[node];
+            size_t      i        = 0;
+            while (position >= internal.counts[i])
+                position -= internal.counts[i++];
+            node = internal.children[i];
+        }
+        return _leaves[node].keys[position];
+    }
+
+    // number of elements less than @p value
+    size_t rank(int value) const
+    {
+        size_t   less = 0;
+        uint32_t node = _root;
+        for (int level = _height; level > 0; --level)
+        {
+            const auto  &internal = _internals[node];
+            const size_t i        = childFor(internal, value);
+            for (size_t j = 0; j < i; ++j)
+                less += internal.counts[j];
+            node = internal.children[i];
+        }
+        const auto &leaf = _leaves[node];
+        return less + (std::lower_bound(leaf.keys.begin(), leaf.keys.begin() + leaf.size, value) - leaf.keys.begin());
+    }
+
+private:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+    struct Leaf
+    {
+        std::array<int, kLeafCapacity> keys;
+        uint32_t                        size = 0;
+    };
+
+    // children[i] holds counts[i] elements, the smallest being lows[i]
+    struct Internal
+    {
+        std::array<uint32_t, kFanout> counts;
+        std::array<int, kFanout>      lows;
+        std::array<uint32_t, kFanout> children;
+        uint32_t                      size = 0;
+    };
+
+    uint32_t newLeaf()
+    {
+        if (!_freeLeaves.empty())
+        {
+            const uint32_t leaf = _freeLeaves.back();
+            _freeLeaves.pop_back();
+            _leaves[leaf].size = 0;
+            return leaf;
+        }
+        _leaves.emplace_back();
+        return _leaves.size() - 1;
+    }
+
+    uint32_t newInternal()
+    {
+        if (!_freeInternals.empty())
+        {
+            const uint32_t internal = _freeInternals.back();
+            _freeInternals.pop_back();
+            _internals[internal].size = 0;
+            return internal;
+        }
+        _internals.emplace_back();
+        return _internals.size() - 1;
+    }
+
+    void release(uint32_t node, int level)
+    {
+        (level == 0 ? _freeLeaves : _freeInternals).push_back(node);
+    }
+
+    // entries of a node: keys of a leaf, children of an internal node
+    uint32_t entries(uint32_t node, int level) const
+    {
+        return level == 0 ? _leaves[node].size : _internals[node].size;
+    }
+
+    uint32_t countOf(uint32_t node, int level) const
+    {
+        if (level == 0)
+            return _leaves[node].size;
+        const auto &internal = _internals[node];
+        uint32_t    count    = 0;
+        for (uint32_t i = 0; i < internal.size; ++i)
+            count += internal.counts[i];
+        return count;
+    }
+
+    int lowOf(uint32_t node, int level) const
+    {
+        return level == 0 ? _leaves[node].keys[0] : _internals[node].lows[0];
+    }
+
+    void append(Internal &parent, uint32_t child, int childLevel)
+    {
+        parent.children[parent.size] = child;
+        parent.counts[parent.size]    = countOf(child, childLevel);
+        parent.lows[parent.size]      = countOf(child, childLevel) > 0 ? lowOf(child, childLevel) : 0;
+        ++parent.size;
+    }
+
+    // last child whose smallest element is less than @p value (or the first):
+    // everything before it is smaller than value, everything after not
+    static size_t childFor(const Internal &internal, int value)
+    {
+        size_t i = 0;
+        while (i + 1 < internal.size && internal.lows[i + 1] < value)
+            ++i;
+        return i;
+    }
+
+    // @return the new right sibling if @p node was split, kNone otherwise
+    uint32_t insertInto(uint32_t node, int level, int value)
+    {
+        if (level == 0)
+        {
+            uint32_t sibling = kNone;
+            if (_leaves[node].size == kLeafCapacity)
+            {
+                sibling      = newLeaf();
+                auto &left   = _leaves[node];
+                auto &right  = _leaves[sibling];
+                const size_t half = kLeafCapacity / 2;
+                std::copy(left.keys.begin() + half, left.keys.end(), right.keys.begin());
+                right.size = kLeafCapacity - half;
+                left.size  = half;
+                if (value >= right.keys[0])
+                    node = sibling;
+            }
+
+            auto      &leaf = _leaves[node];
+            const auto end  = leaf.keys.begin() + leaf.size;
+            const auto at   = std::upper_bound(leaf.keys.begin(), end, value);
+            std::copy_backward(at, end, end + 1);
+            *at = value;
+            ++leaf.size;
+            return sibling;
+        }
+
+        size_t         i     = childFor(_internals[node], value);
+        const uint32_t split = insertInto(_internals[node].children[i], level - 1, value);
+
+        auto &internal = _internals[node];
+        ++internal.counts[i];
+        internal.lows[i] = std::min(internal.lows[i], value);
+        if (split == kNone)
+            return kNone;
+
+        uint32_t sibling = kNone;
+        uint32_t target  = node;
+        if (internal.size == kFanout)
+        {
+            sibling            = newInternal();
+            auto        &left  = _internals[node];
+            auto        &right = _internals[sibling];
+            const size_t half  = kFanout / 2;
+            std::copy(left.counts.begin() + half, left.counts.end(), right.counts.begin());
+            std::copy(left.lows.begin() + half, left.lows.end(), right.lows.begin());
+            std::copy(left.children.begin() + half, left.children.end(), right.children.begin());
+            right.size = kFanout - half;
+            left.size  = half;
+            if (i >= half)
+            {
+                target = sibling;
+                i -= half;
+            }
+        }
+
+        auto &parent = _internals[target];
+        for (size_t j = parent.size; j > i + 1; --j)
+        {
+            parent.counts[j]   = parent.counts[j - 1];
+            parent.lows[j]     = parent.lows[j - 1];
+            parent.children[j] = parent.children[j - 1];
+        }
+        parent.children[i + 1] = split;
+        parent.counts[i + 1]   = countOf(split, level - 1);
+        parent.lows[i + 1]     = lowOf(split, level - 1);
+        parent.counts[i] -= parent.counts[i + 1];
+        ++parent.size;
+        return sibling;
+    }
+
+    void removeChild(Internal &internal, size_t i)
+    {
+        for (size_t j = i; j + 1 < internal.size; ++j)
+        {
+            internal.counts[j]   = internal.counts[j + 1];
+            internal.lows[j]     = internal.lows[j + 1];
+            internal.children[j] = internal.children[j + 1];
+        }
+        --internal.size;
+    }
+
+    // moves the entries of @p right to the end of @p left
+    void mergeNodes(uint32_t left, uint32_t right, int level)
+    {
+        if (level == 0)
+        {
+            auto &l = _leaves[left];
+            auto &r = _leaves[right];
+            std::copy_n(r.keys.begin(), r.size, l.keys.begin() + l.size);
+            l.size += r.size;
+            return;
+        }
+        auto &l = _internals[left];
+        auto &r = _internals[right];
+        std::copy_n(r.counts.begin(), r.size, l.counts.begin() + l.size);
+        std::copy_n(r.lows.begin(), r.size, l.lows.begin() + l.size);
+        std::copy_n(r.children.begin(), r.size, l.children.begin() + l.size);
+        l.size += r.size;
+    }
+
+    // erases the element at 0-based @p position of the subtree of @p node
+    void eraseAt(uint32_t node, int level, size_t position)
+    {
+        if (level == 0)
+        {
+            auto &leaf = _leaves[node];
+            std::copy(leaf.keys.begin() + position + 1, leaf.keys.begin() + leaf.size, leaf.keys.begin() + position);
+            --leaf.size;
+            return;
+        }
+
+        auto  &internal = _internals[node];
+        size_t i        = 0;
+        while (position >= internal.counts[i])
+            position -= internal.counts[i++];
+
+        const uint32_t child = internal.children[i];
+        eraseAt(child, level - 1, position);
+        --internal.counts[i];
+
+        if (internal.counts[i] == 0)
+        {
+            release(child, level - 1);
+            removeChild(internal, i);
+            return;
+        }
+        internal.lows[i] = lowOf(child, level - 1);
+
+        const size_t capacity = level == 1 ? kLeafCapacity : kFanout;
+        if (entries(child, level - 1) >= capacity / 4 || internal.size == 1)
+            return;
+
+        const size_t left  = i + 1 < internal.size ? i : i - 1;
+        const size_t right = left + 1;
+        if (entries(internal.children[left], level - 1) + entries(internal.children[right], level - 1) > capacity)
+            return;
+
+        mergeNodes(internal.children[left], internal.children[right], level - 1);
+        internal.counts[left] += internal.counts[right];
+        release(internal.children[right], level - 1);
+        removeChild(internal, right);
+    }
+
+    std::vector<Leaf>     _leaves;
+    std::vector<Internal> _internals;
+    std::vector<uint32_t> _freeLeaves;
+    std::vector<uint32_t> _freeInternals;
+    uint32_t              _root   = kNone;
+    int                   _height = 0;    // levels of internal nodes above the leaves
+    size_t                _size   = 0;
+};
+
+/**
+ * @brief multiset of ints from [lo, hi] with the same interface as
+ * OrderStatisticTree on a Fenwick tree of per-value counts: O(log(hi - lo))
+ * per operation with a flat array and no node splits, kth by binary lifting;
+ * takes 8 bytes per value of the domain
+ */
+class FenwickOrderStatistics
+{
+public:
+    FenwickOrderStatistics(int lo, int hi) : _lo{ lo }
+    {
+        const long long domain = static_cast<long long>(hi) - lo + 1;
+        if (domain <= 0)
+            throw std::runtime_error{ "FenwickOrderStatistics: empty domain" };
+        _tree.assign(domain + 1, 0);
+        _counts.assign(domain, 0);
+        _highBit = std::bit_floor(static_cast<size_t>(domain));
+    }
+
+    size_t size() const { return _size; }
+
+    void insert(int value)
+    {
+        const size_t i = index(value);
+        if (i == _counts.size())
+            throw std::runtime_error{ "FenwickOrderStatistics: value outside the domain" };
+        ++_counts[i];
+        add(i, 1);
+        ++_size;
+    }
+
+    bool erase(int value)
+    {
+        const size_t i = index(value);
+        if (i == _counts.size() || _counts[i] == 0)
+            return false;
+        --_counts[i];
+        add(i, -1);
+        --_size;
+        return true;
+    }
+
+    int kth(size_t k) const
+    {
+        size_t position = 0;
+        for (size_t step = _highBit; step > 0; step /= 2)
+        {
+            if (position + step < _tree.size() && _tree[position + step] < k)
+            {
+                position += step;
+                k -= _tree[position];
+            }
+        }
+        return static_cast<int>(_lo + static_cast<long long>(position));
+    }
+
+    size_t rank(int value) const
+    {
+        const long long offset = static_cast<long long>(value) - _lo;
+        size_t          end    = std::clamp<long long>(offset, 0, _counts.size());
+        size_t          less   = 0;
+        for (; end > 0; end &= end - 1)
+            less += _tree[end];
+        return less;
+    }
+
+private:
+    // position of @p value in _counts, _counts.size() if outside the domain
+    size_t index(int value) const
+    {
+        const long long offset = static_cast<long long>(value) - _lo;
+        return offset < 0 || offset >= static_cast<long long>(_counts.size()) ? _counts.size() : offset;
+    }
+
+    void add(size_t i, int delta)
+    {
+        for (++i; i < _tree.size(); i += i & (~i + 1))
+            _tree[i] += delta;
+    }
+
+    int                   _lo;
+    std::vector<uint32_t> _tree;      // 1-based Fenwick tree over _counts
+    std::vector<uint32_t> _counts;
+    size_t                _highBit = 0;
+    size_t                _size    = 0;
+};
+
+/**
+ * @brief one step of an update/query stream for the containers above
+ */
+struct OrderStatisticOp
+{
+    enum class Kind
+    {
+        Insert,
+        Erase,
+        Kth,
+    };
+
+    Kind kind;
+    int  value;    // inserted / erased element, or the 1-based rank for Kth
+};
+
+/**
+ * @brief applies @p ops to @p container in order
+ *
+ * @return std::vector<int> - answers of the Kth ops; erases of missing values
+ * are ignored, Kth ranks have to be within the current size
+ */
+template <typename Container>
+std::vector<int> orderStatisticStream1(Container &container, const std::vector<OrderStatisticOp> &ops)
+{
+    std::vector<int> answers;
+    for (const auto &op : ops)
+    {
+        switch (op.kind)
+        {
+        case OrderStatisticOp::Kind::Insert:
+            container.insert(op.value);
+            break;
+        case OrderStatisticOp::Kind::Erase:
+            container.erase(op.value);
+            break;
+        case OrderStatisticOp::Kind::Kth:
+            answers.push_back(container.kth(op.value));
+            break;
+        }
+    }
+    return answers;
+}
+
+// --------------------
+// Wavelet matrix: range kth / count / median over a static array
+// --------------------
+
+/**
+ * @brief immutable bit vector with O(1) rank by popcount
+ *
+ * Bits are stored in 64-byte blocks of seven 64-bit words plus the number of
+ * ones before the block, so a rank touches a single cache line: the block's
+ * count, up to six whole-word popcounts and a masked one. 512 bits of storage
+ * per 448 bits of data.
+ */
+class RankBitVector
+{
+public:
+    RankBitVector() = default;
+
+    explicit RankBitVector(size_t size) : _blocks(size / kBlockBits + 1) {}
+
+    void set(size_t i) { _blocks[i / kBlockBits].words[i % kBlockBits / 64] |= uint64_t{ 1 } << (i % 64); }
+
+    // fills in the block counts, call once after all set() calls
+    void finish()
+    {
+        uint64_t ones = 0;
+        for (auto &block : _blocks)
+        {
+            block.before = ones;
+            for (const auto word : block.words)
+                ones += std::popcount(word);
+        }
+    }
+
+    bool get(size_t i) const { return _blocks[i / kBlockBits].words[i % kBlockBits / 64] >> (i % 64) & 1; }
+
+    // number of ones in [0, i)
+    size_t rank1(size_t i) const
+    {
+        const auto  &block  = _blocks[i / kBlockBits];
+        const size_t bit    = i % kBlockBits;
+        size_t       ones   = block.before;
+        const size_t words  = bit / 64;
+        for (size_t w = 0; w < words; ++w)
+            ones += std::popcount(block.words[w]);
+        if (bit % 64 != 0)
+            ones += std::popcount(block.words[words] & ((uint64_t{ 1 } << (bit % 64)) - 1));
+        return ones;
+    }
+
+    size_t rank0(size_t i) const { return i - rank1(i); }
+
+    size_t memoryBytes() const { return _blocks.size() * sizeof(Block); }
+
+private:
+    static constexpr size_t kBlockWords = 7;
+    static constexpr size_t kBlockBits  = kBlockWords * 64;
+
+    struct alignas(64) Block
+    {
+        uint64_t                           before = 0;
+        std::array<uint64_t, kBlockWords> words{};
+    };
+
+    std::vector<Block> _blocks;
+};
+
+/**
+ * @brief wavelet matrix of an int array for
+ * O(log sigma) range queries, sigma being the number of distinct values
+ *
+ * Values are replaced by their dense ranks (codes) among the distinct values,
+ * so an array with few distinct values needs few levels whatever their
+ * magnitude. Level l holds bit (levels - 1 - l) of every code in the order left
+ * by the previous level, which stably moves codes with a 0 bit before those
+ * with a 1 bit; a position range [l, r) maps to the next level by two ranks.
+ * Built in O(n log sigma), about 1.14 * log2(sigma) bits per element plus
+ * the distinct values.
+ */
+class WaveletMatrix
+{
+public:
+    explicit WaveletMatrix(const std::vector<int> &v) : _size{ v.size() }, _values{ v }
+    {
+        std::sort(_values.begin(), _values.end());
+        _values.erase(std::unique(_values.begin(), _values.end()), _values.end());
+
+        std::vector<uint32_t> codes(v.size());
+        for (size_t i = 0; i < v.size(); ++i)
+            codes[i] = std::lower_bound(_values.begin(), _values.end(), v[i]) - _values.begin();
+
+        const int levels = _values.empty() ? 0 : std::bit_width(_values.size() - 1);
+        _levels.reserve(levels);
+        _zeros.reserve(levels);
+
+        std::vector<uint32_t> next(v.size());
+        for (int level = 0; level < levels; ++level)
+        {
+            const int shift = levels - 1 - level;
+            auto     &bits  = _levels.emplace_back(v.size());
+
+            size_t zeros = 0;
+            for (size_t i = 0; i < codes.size(); ++i)
+            {
+                if (codes[i] >> shift & 1)
+                    bits.set(i);
+                else
+                    ++zeros;
+            }
+            bits.finish();
+            _zeros.push_back(zeros);
+
+            size_t zero = 0;
+            size_t one  = zeros;
+            for (const auto code : codes)
+                next[code >> shift & 1 ? one++ : zero++] = code;
+            codes.swap(next);
+        }
+    }
+
+    size_t size() const { return _size; }
+
+    // 1-based @p k th smallest of positions [l, r] (inclusive), 1 <= k <= r - l + 1
+    int rangeKth(size_t l, size_t r, size_t k) const
+    {
+        ++r;
+        --k;
+        uint32_t code = 0;
+        for (size_t level = 0; level < _levels.size(); ++level)
+        {
+            const auto  &bits   = _levels[level];
+            const size_t onesL  = bits.rank1(l);
+            const size_t onesR  = bits.rank1(r);
+            const size_t zeros  = (r - l) - (onesR - onesL);
+            code <<= 1;
+            if (k < zeros)
+            {
+                l -= onesL;
+                r -= onesR;
+            }
+            else
+            {
+                k -= zeros;
+                code |= 1;
+                l = _zeros[level] + onesL;
+                r = _zeros[level] + onesR;
+            }
+        }
+        return _values[code];
+    }
+
+    // number of positions in [l, r] (inclusive) holding a value in [lo, hi]
+    size_t rangeCount(size_t l, size_t r, int lo, int hi) const
+    {
+        if (lo > hi)
+            return 0;
+        const size_t below = std::lower_bound(_values.begin(), _values.end(), lo) - _values.begin();
+        const size_t upTo  = std::upper_bound(_values.begin(), _values.end(), hi) - _values.begin();
+        return countLess(l, r + 1, upTo) - countLess(l, r + 1, below);
+    }
+
+    // median of positions [l, r] (inclusive), the average of both middle elements for even lengths
+    double rangeMedian(size_t l, size_t r) const
+    {
+        const size_t    length = r - l + 1;
+        const long long lower  = rangeKth(l, r, (length + 1) / 2);
+        const long long upper  = length % 2 == 1 ? lower : rangeKth(l, r, length / 2 + 1);
+        return (lower + upper) / 2.0;
+    }
+
+    size_t memoryBytes() const
+    {
+        size_t bytes = _values.size() * sizeof(int) + _zeros.size() * sizeof(size_t);
+        for (const auto &bits : _levels)
+            bytes += bits.memoryBytes();
+        return bytes;
+    }
+
+private:
+    // number of positions in [l, r) whose code is less than @p code
+    size_t countLess(size_t l, size_t r, size_t code) const
+    {
+        if (code >= _values.size())
+            return r - l;
+
+        size_t less = 0;
+        for (size_t level = 0; level < _levels.size(); ++level)
+        {
+            const auto  &bits  = _levels[level];
+            const size_t onesL = bits.rank1(l);
+            const size_t onesR = bits.rank1(r);
+            if (code >> (_levels.size() - 1 - level) & 1)
+            {
+                less += (r - l) - (onesR - onesL);
+                l = _zeros[level] + onesL;
+                r = _zeros[level] + onesR;
+            }
+            else
+            {
+                l -= onesL;
+                r -= onesR;
+            }
+        }
+        return less;
+    }
+
+    size_t                     _size;
+    std::vector<int>           _values;    // distinct values, ascending: code -> value
+    std::vector<RankBitVector> _levels;
+    std::vector<size_t>        _zeros;     // number of 0 bits per level
+};
 
 // --------------------
 // --------------------
@@ -97,7 +3954,9 @@ enum class PivotPolicy
     Deterministic,
     UniformRandom,
     MedianDeterministic,
-    MedianUniformRandom
+    MedianUniformRandom,
+    Introselect,
+    FloydRivest
 };
 
 enum class InputData
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
 #include <stdexcept>
 #include <utility>
 #include <vector>
@@ -28,8 +32,453 @@ std::pair<int, int> minMaxElement(const std::vector<int> &v)
    std::pair<int, int> myPair(min, max);
    return myPair;
 }
+
+/**
+ * @brief deque of indices kept in a ring buffer of power-of-two capacity:
+ * values at the stored indices are strictly monotonic (increasing for
+ * Compare = std::less, decreasing for std::greater), so the front is the
+ * min/max of the current window
+ */
+template <typename Compare>
+class MonotonicRing
+{
+public:
+    void reset(size_t window)
+    {
+        const size_t capacity = std::bit_ceil(window);
+        if (_slots.size() < capacity)
+            _slots.resize(capacity);
+        _mask = capacity - 1;
+        _head = 0;
+        _tail = 0;
+    }
+
+    void push(const int *data, size_t i)
+    {
+        Compare compare;
+        while (_tail != _head && !compare(data[_slots[(_tail - 1) & _mask]], data[i]))
+            --_tail;
+        _slots[_tail++ & _mask] = i;
+    }
+
+    // drops the front if it is older than @p first
+    void expire(size_t first)
+    {
+        if (_head != _tail && _slots[_head & _mask] < first)
+            ++_head;
+    }
+
+    size_t front() const { return _slots[_head & _mask]; }
+
+private:
+    std::vector<size_t> _slots;
+    size_t              _mask = 0;
+    size_t              _head = 0;
+    size_t              _tail = 0;
+};
+
+/**
+ * @brief rolling min/max engine, its ring buffers only grow, so reusing one
+ * object for many series allocates nothing after the longest window was seen
+ */
+class SlidingMinMax
+{
+public:
+    /**
+     * @brief writes mins[i]/maxs[i] = min/max of data[i..i + window) for all
+     * size - window + 1 windows, in one pass
+     */
+    void run(const int *data, size_t size, size_t window, int *mins, int *maxs)
+    {
+        _min.reset(window);
+        _max.reset(window);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            // expire before pushing, so that at most window indices are stored
+            if (i >= window)
+            {
+                _min.expire(i + 1 - window);
+                _max.expire(i + 1 - window);
+            }
+            _min.push(data, i);
+            _max.push(data, i);
+            if (i + 1 < window)
+                continue;
+
+            mins[i + 1 - window] = data[_min.front()];
+            maxs[i + 1 - window] = data[_max.front()];
+        }
+    }
+
+private:
+    MonotonicRing<std::less<>>    _min;
+    MonotonicRing<std::greater<>> _max;
+};
+
+/**
+ * @brief min and max of every window of @p window consecutive elements of @p v
+ *
+ * @param v
+ * @param window - window length
+ * @param mins - resized to v.size() - window + 1, mins[i] is the min of v[i..i + window)
+ * @param maxs - same for max
+ *
+ * Constraints:
+ *      1. 1 <= window <= v.size()
+ * Examples:
+ *      v = [3, 1, 4, 1, 5], window = 3 ---> mins = [1, 1, 1], maxs = [4, 4, 5]
+ */
+void slidingMinMax(const std::vector<int> &v, size_t window, std::vector<int> &mins, std::vector<int> &maxs)
+{
+    mins.resize(v.size() - window + 1);
+    maxs.resize(v.size() - window + 1);
+
+    SlidingMinMax engine;
+    engine.run(v.data(), v.size(), window, mins.data(), maxs.data());
+}
+
+/**
+ * @brief slidingMinMax for many independent series with one engine, so the
+ * buffers are allocated once for the whole batch
+ *
+ * Constraints:
+ *      1. 1 <= window <= series[i].size() for every i
+ */
+void slidingMinMaxBatch(
+    const std::vector<std::vector<int>> &series,
+    size_t                               window,
+    std::vector<std::vector<int>>       &mins,
+    std::vector<std::vector<int>>       &maxs)
+{
+    mins.resize(series.size());
+    maxs.resize(series.size());
+
+    SlidingMinMax engine;
+    for (size_t i = 0; i < series.size(); ++i)
+    {
+        mins[i].resize(series[i].size() - window + 1);
+        maxs[i].resize(series[i].size() - window + 1);
+        engine.run(series[i].data(), series[i].size(), window, mins[i].data(), maxs[i].data());
+    }
+}
+
+/**
+ * @brief most frequent value (the smallest one on ties), its number of
+ * occurrences and the number of distinct values
+ */
+struct FrequencyStats
+{
+    int    mode;
+    size_t modeCount;
+    size_t distinct;
+};
+
+// (value, occurrences), heavy hitters are ordered by count desc, then value asc
+using ValueCount = std::pair<int, size_t>;
+
+bool moreFrequent(const ValueCount &a, const ValueCount &b)
+{
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+}
+
+/**
+ * @brief sorts @p v with three LSD radix passes over 11-bit digits (sign bit
+ * flipped, so the order is that of signed ints), @p buffer is scratch of the
+ * same size
+ *
+ * 11-bit digits keep each pass's 2048 counters in L1, 16-bit ones would need
+ * two passes but a 256K counter table which dominates for small vectors.
+ */
+void radixSort(std::vector<int> &v, std::vector<int> &buffer)
+{
+    constexpr int    kDigitBits = 11;
+    constexpr size_t kDigits    = size_t{ 1 } << kDigitBits;
+
+    buffer.resize(v.size());
+    for (int shift = 0; shift < 32; shift += kDigitBits)
+    {
+        const auto digit = [shift](int value)
+        { return ((static_cast<uint32_t>(value) ^ 0x80000000u) >> shift) & (kDigits - 1); };
+
+        std::vector<uint32_t> offsets(kDigits + 1, 0);
+        for (const auto value : v)
+            ++offsets[digit(value) + 1];
+        // every value has the same digit: the pass would not move anything
+        if (std::find(offsets.begin(), offsets.end(), v.size()) != offsets.end())
+            continue;
+        for (size_t d = 1; d < offsets.size(); ++d)
+            offsets[d] += offsets[d - 1];
+        for (const auto value : v)
+            buffer[offsets[digit(value)]++] = value;
+        v.swap(buffer);
+    }
+}
+
+/**
+ * @brief runs of equal values of @p v as (value, run length), in ascending
+ * order of values (exact path: radix sort + one scan)
+ */
+std::vector<ValueCount> groupSorted(const std::vector<int> &v)
+{
+    std::vector<int> sorted = v;
+    std::vector<int> buffer;
+    radixSort(sorted, buffer);
+
+    std::vector<ValueCount> groups;
+    for (size_t i = 0; i < sorted.size();)
+    {
+        size_t j = i;
+        while (j < sorted.size() && sorted[j] == sorted[i])
+            ++j;
+        groups.emplace_back(sorted[i], j - i);
+        i = j;
+    }
+    return groups;
+}
+
+/**
+ * @brief open-addressing (linear probing) table of int keys and counts in two
+ * flat arrays, a zero count marks an empty slot; grows at load factor 1/2
+ */
+class FlatCounter
+{
+public:
+    explicit FlatCounter(size_t expected = 16) { reset(std::bit_ceil(std::max<size_t>(2 * expected, 16))); }
+
+    size_t size() const { return _size; }
+
+    void add(int key, size_t count = 1)
+    {
+        if (2 * (_size + 1) > _keys.size())
+            grow();
+
+        size_t i = slot(key);
+        while (_counts[i] != 0 && _keys[i] != key)
+            i = (i + 1) & _mask;
+
+        if (_counts[i] == 0)
+        {
+            _keys[i] = key;
+            ++_size;
+        }
+        _counts[i] += count;
+    }
+
+    // count of @p key, or nullptr if it is not in the table
+    size_t *find(int key)
+    {
+        for (size_t i = slot(key); _counts[i] != 0; i = (i + 1) & _mask)
+        {
+            if (_keys[i] == key)
+                return &_counts[i];
+        }
+        return nullptr;
+    }
+
+    template <typename F>
+    void forEach(F fn) const
+    {
+        for (size_t i = 0; i < _keys.size(); ++i)
+        {
+            if (_counts[i] != 0)
+                fn(_keys[i], _counts[i]);
+        }
+    }
+
+private:
+    // Fibonacci hashing: the top bits of key * 2^64 / phi
+    size_t slot(int key) const
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> _shift;
+    }
+
+    void reset(size_t capacity)
+    {
+        _keys.assign(capacity, 0);
+        _counts.assign(capacity, 0);
+        _mask  = capacity - 1;
+        _shift = 64 - std::countr_zero(capacity);
+        _size  = 0;
+    }
+
+    void grow()
+    {
+        auto keys   = std::move(_keys);
+        auto counts = std::move(_counts);
+        reset(2 * keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (counts[i] != 0)
+                add(keys[i], counts[i]);
+        }
+    }
+
+    std::vector<int>    _keys;
+    std::vector<size_t> _counts;
+    size_t              _mask  = 0;
+    int                 _shift = 0;
+    size_t              _size  = 0;
+};
+
+/**
+ * @brief Misra-Gries summary with @p counters counters: after n updates every
+ * value occurring more than n / (counters + 1) times has a counter, and each
+ * counter underestimates its value's frequency by at most errorBound() <=
+ * n / (counters + 1)
+ *
+ * When all counters are taken a new value decrements every counter instead;
+ * the table is then rebuilt without the zeroed ones, O(counters) for every
+ * counters + 1 updates that were discarded, so O(1) amortized.
+ */
+class MisraGries
+{
+public:
+    explicit MisraGries(size_t counters) : _counters{ std::max<size_t>(counters, 1) }, _table{ _counters } {}
+
+    void update(int value)
+    {
+        if (auto *count = _table.find(value))
+        {
+            ++*count;
+            return;
+        }
+        if (_table.size() < _counters)
+        {
+            _table.add(value);
+            return;
+        }
+
+        ++_decrements;
+        FlatCounter survivors{ _counters };
+        _table.forEach(
+            [&](int key, size_t count)
+            {
+                if (count > 1)
+                    survivors.add(key, count - 1);
+            });
+        _table = std::move(survivors);
+    }
+
+    size_t errorBound() const { return _decrements; }
+
+    // (value, estimated count) of all counters, ordered as heavy hitters
+    std::vector<ValueCount> candidates() const
+    {
+        std::vector<ValueCount> result;
+        _table.forEach([&](int key, size_t count) { result.emplace_back(key, count); });
+        std::sort(result.begin(), result.end(), moreFrequent);
+        return result;
+    }
+
+private:
+    size_t      _counters;
+    FlatCounter _table;
+    size_t      _decrements = 0;
+};
+
+FrequencyStats frequencyStatsOf(const std::vector<ValueCount> &groups)
+{
+    FrequencyStats res{ 0, 0, groups.size() };
+    for (const auto &group : groups)
+    {
+        if (res.modeCount == 0 || moreFrequent(group, { res.mode, res.modeCount }))
+        {
+            res.mode      = group.first;
+            res.modeCount = group.second;
+        }
+    }
+    return res;
+}
+
+std::vector<ValueCount> topOf(std::vector<ValueCount> groups, size_t m)
+{
+    m = std::min(m, groups.size());
+    std::partial_sort(groups.begin(), groups.begin() + m, groups.end(), moreFrequent);
+    groups.resize(m);
+    return groups;
+}
+
+std::vector<ValueCount> groupHashed(const std::vector<int> &v)
+{
+    FlatCounter table;
+    for (const auto value : v)
+        table.add(value);
+
+    std::vector<ValueCount> groups;
+    groups.reserve(table.size());
+    table.forEach([&](int key, size_t count) { groups.emplace_back(key, count); });
+    return groups;
+}
+
+/**
+ * @brief mode, its count and number of distinct values of @p v, exact, by
+ * radix sorting a copy of @p v and scanning its runs
+ *
+ * Constraints:
+ *      1. @p v is not empty
+ * Examples:
+ *      v = [3, 1, 3, 2, 1] ---> mode = 1, modeCount = 2, distinct = 3
+ */
+FrequencyStats frequencyStatsSorted(const std::vector<int> &v)
+{
+    return frequencyStatsOf(groupSorted(v));
+}
+
+/**
+ * @brief same as frequencyStatsSorted, counting in a FlatCounter hash table
+ * (O(distinct) memory instead of a copy of @p v)
+ */
+FrequencyStats frequencyStatsHashed(const std::vector<int> &v)
+{
+    return frequencyStatsOf(groupHashed(v));
+}
+
+/**
+ * @brief @p m most frequent values of @p v with their counts, ordered by
+ * count desc, then value asc (fewer if @p v has fewer distinct values)
+ */
+std::vector<ValueCount> heavyHittersSorted(const std::vector<int> &v, size_t m)
+{
+    return topOf(groupSorted(v), m);
+}
+
+std::vector<ValueCount> heavyHittersHashed(const std::vector<int> &v, size_t m)
+{
+    return topOf(groupHashed(v), m);
+}
+
+/**
+ * @brief approximate heavyHitters in one pass with O(@p counters) memory
+ * (MisraGries): every value occurring more than v.size() / (counters + 1)
+ * times is reported, counts are lower bounds off by at most that much
+ */
+std::vector<ValueCount> heavyHittersStreaming(const std::vector<int> &v, size_t m, size_t counters)
+{
+    MisraGries summary{ counters };
+    for (const auto value : v)
+        summary.update(value);
+
+    auto candidates = summary.candidates();
+    candidates.resize(std::min(m, candidates.size()));
+    return candidates;
+}
+
 // lengths of vectors to benchmark (feel free to change)
 const std::vector<long long> Ns{ 100, 600, 1100, 1600, 2100 };
 
+// series lengths and window lengths for slidingMinMax (feel free to change)
+const std::vector<long long> slidingNs{ 10000, 100000 };
+const std::vector<long long> slidingWindows{ 10, 100, 1000 };
+// number of series (each slidingNs.front() long) for slidingMinMaxBatch
+const std::vector<long long> slidingBatchSeries{ 10, 100 };
+
+// lengths of vectors for the frequency statistics, each with values in
+// [-1000, 1000] and in the whole int range (feel free to change)
+const std::vector<long long> frequencyNs{ 10000, 100000, 1000000 };
+// number of heavy hitters requested and Misra-Gries counters (feel free to change)
+const long long heavyHittersM        = 10;
+const long long heavyHittersCounters = 100;
+
 // don't touch
 #include "utils/min-max-element.h"
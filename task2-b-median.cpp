@@ -1,10 +1,12 @@
 #include <stdexcept>
+#include <utility>
 #include <vector>
 #include "common.h"
 // Note: pivot functions are not used in this source file, since
 // calculation of median might required finding 2 middle elements
 // in case the array length is even (and pivot functions in common.h)
-// are not really designed for this
+// are not really designed for this. The exception is medianPair, which
+// finds both middle elements with one selection run
 
 /**
  * @brief calculate median of @p v in deterministic fashion
@@ -30,6 +32,301 @@ double medianUniformRandomPivot(std::vector<int> &v)
     return medianUniformRandomPivot1(v);
 }
 
+double medianIntroselect(std::vector<int> &v)
+{
+    return medianIntroselect1(v);
+}
+
+/**
+ * @brief calculate lower and upper median of @p v with a single selection run
+ *
+ * @param v
+ * @param pivotFunction - same as for quickSelect
+ *
+ * Constraints:
+ *      1. v.size() >= 1
+ * Examples:
+ *      v = [1]       ---> (1, 1)
+ *      v = [2, 1]    ---> (1, 2)
+ *      v = [3, 4, 4] ---> (4, 4)
+ *
+ * @return std::pair<int, int> - lower and upper median of @p v (equal for odd
+ * sizes), the median is their average
+ */
+std::pair<int, int> medianPair(std::vector<int> &v, Pivot_f pivotFunction)
+{
+    return medianPair1(v, pivotFunction);
+}
+
+/**
+ * @brief calculate median of @p v without modifying it: the work is done in
+ * @p scratch, which can be reused between calls without further allocations
+ *
+ * @param v
+ * @param pivotFunction - same as for quickSelect
+ * @param scratch - resized to v.size(), its contents are overwritten
+ *
+ * Constraints:
+ *      1. v.size() >= 1
+ *
+ * @return double - median of @p v
+ */
+double medianConst(const std::vector<int> &v, Pivot_f pivotFunction, std::vector<int> &scratch)
+{
+    return medianConst1(v, pivotFunction, scratch);
+}
+
+/**
+ * @brief same as above with the scratch buffer of the calling thread
+ */
+double medianConst(const std::vector<int> &v, Pivot_f pivotFunction)
+{
+    return medianConst1(v, pivotFunction, threadLocalScratch());
+}
+
+/**
+ * @brief calculate median of data that is only readable sequentially (e.g. a
+ * file larger than RAM) with a bounded amount of memory
+ *
+ * @param source - SpanSource or Int32FileSource from common.h, not empty
+ * @param memoryBudget - same as for multiPassSelect1 in common.h
+ *
+ * @return double - median of @p source
+ */
+template <typename Source>
+double multiPassMedian(const Source &source, size_t memoryBudget)
+{
+    return multiPassMedian1(source, memoryBudget);
+}
+
+/**
+ * @brief calculate median of the union of @p shards without concatenating them
+ *
+ * @param shards - not all empty, elements are reordered inside their shards
+ * @param threads - same as for shardedSelect1 in common.h
+ *
+ * @return double - median of all elements of @p shards
+ */
+double shardedMedian(std::vector<std::vector<int>> &shards, size_t threads)
+{
+    return shardedMedian1(shards, threads);
+}
+
+/**
+ * @brief calculate weighted median: the median of the array in which every
+ * values[i] is repeated weights[i] times, without building that array
+ *
+ * @param values
+ * @param weights - weights[i] >= 0 is the weight of values[i]
+ * @param pivotFunction - same as for quickSelect
+ *
+ * Constraints:
+ *      1. values.size() == weights.size() >= 1
+ *      2. total weight is positive
+ * Examples:
+ *      values = [1, 2, 3], weights = [1, 1, 5] ---> 3
+ *      values = [1, 2],    weights = [3, 3]    ---> 1.5
+ *
+ * @return double - weighted median, @p values and @p weights are reordered
+ * together
+ */
+double weightedMedian(std::vector<int> &values, std::vector<long long> &weights, Pivot_f pivotFunction)
+{
+    return weightedMedian1(values, weights, pivotFunction);
+}
+
+/**
+ * @brief calculate weighted quantile @p q (0 <= q <= 1): the element at rank
+ * max(1, ceil(q * W)) of the expanded array, W being the total weight. Same
+ * constraints as weightedMedian
+ */
+int weightedQuantile(std::vector<int> &values, std::vector<long long> &weights, double q, Pivot_f pivotFunction)
+{
+    return weightedQuantile1(values, weights, q, pivotFunction);
+}
+
+/**
+ * @brief calculate median of every prefix of @p v incrementally (RunningMedian
+ * from common.h) instead of recomputing it over the whole history
+ *
+ * Examples:
+ *      v = [3, 1, 2] ---> [3, 2, 2]
+ *
+ * @return std::vector<double> - result[i] is the median of v[0..i]
+ */
+std::vector<double> runningMedians(const std::vector<int> &v)
+{
+    std::vector<double> result;
+    result.reserve(v.size());
+
+    RunningMedian median;
+    for (const auto value : v)
+    {
+        median.insert(value);
+        result.push_back(median.median());
+    }
+    return result;
+}
+
+/**
+ * @brief calculate medians of all windows of @p window consecutive elements of @p v
+ *
+ * @param v
+ * @param window - window length
+ * @param medians - resized to v.size() - window + 1, medians[i] is the median
+ * of v[i..i + window)
+ *
+ * Constraints:
+ *      1. 1 <= window <= v.size()
+ * Examples:
+ *      v = [1, 3, 2, 5], window = 2 ---> [2, 2.5, 3.5]
+ */
+void slidingWindowMedian(const std::vector<int> &v, size_t window, std::vector<double> &medians)
+{
+    medians.resize(v.size() - window + 1);
+    slidingWindowMedian1(v.data(), v.size(), window, medians.data());
+}
+
+/**
+ * @brief approximate median of non-negative values (e.g. latencies) recorded
+ * into an HdrHistogram (common.h) in O(1) per value, without storing them
+ *
+ * Constraints:
+ *      1. v.size() >= 1, all values are >= 0
+ *
+ * @return int - lower median of @p v with a relative error of at most 2^-7
+ * (exact for values below 128)
+ */
+int histogramMedian(const std::vector<int> &v)
+{
+    HdrHistogram<> histogram;
+    for (const auto value : v)
+        histogram.record(value);
+    return histogram.quantile(0.5);
+}
+
+/**
+ * @brief calculate median, MAD, quartiles and trimmed/winsorized means of @p v
+ * sharing the partitioning work (see robustStats1 in common.h)
+ *
+ * @param v
+ * @param trim - fraction of elements cut from each end for the trimmed and
+ * winsorized means, 0 <= trim < 0.5
+ * @param pivotFunction - same as for quickSelect
+ *
+ * Constraints:
+ *      1. v.size() >= 1
+ * Examples:
+ *      v = [1, 2, 3, 4, 100], trim = 0.2 ---> median = 3, mad = 1,
+ *      quartiles = (2, 4), trimmedMean = 3, winsorizedMean = 3
+ *
+ * @return RobustStats - @p v is reordered
+ */
+RobustStats robustStats(std::vector<int> &v, double trim, Pivot_f pivotFunction)
+{
+    return robustStats1(v, trim, pivotFunction, threadLocalScratch());
+}
+
+/**
+ * @brief median filter of a row-major image: every pixel is replaced by the
+ * median of the (2 * radius + 1) x (2 * radius + 1) window around it, pixels
+ * outside the image replicate the nearest edge pixel
+ *
+ * @param image - image.size() is a multiple of @p cols
+ * @param cols - image width
+ * @param radius
+ * @param threads - rows are split into this many bands filtered in parallel
+ * @param method - see MedianFilterMethod in common.h, Auto picks by radius and
+ * number of distinct values
+ * @param filtered - resized to image.size()
+ *
+ * Examples:
+ *      image = [1, 9, 2,
+ *               8, 3, 7], cols = 3, radius = 1 ---> [3, 3, 3,
+ *                                                    8, 7, 7]
+ */
+void medianFilter(
+    const std::vector<int> &image,
+    size_t                  cols,
+    size_t                  radius,
+    size_t                  threads,
+    MedianFilterMethod      method,
+    std::vector<int>       &filtered)
+{
+    filtered.resize(image.size());
+    medianFilter2D1(image.data(), cols == 0 ? 0 : image.size() / cols, cols, radius, filtered.data(), threads, method);
+}
+
+/**
+ * @brief calculate the median of every group of a flat array in one call,
+ * without splitting it into per-group vectors
+ *
+ * @param values - group g is values[offsets[g]..offsets[g + 1]), it is
+ * reordered in place
+ * @param offsets - offsets.front() == 0, offsets.back() == values.size()
+ * @param threads - groups are spread over this many threads
+ * @param medians - resized to offsets.size() - 1, medians[g] is the median of
+ * group g
+ *
+ * Constraints:
+ *      1. every group is non-empty
+ * Examples:
+ *      values = [5, 1, 3, 2, 4], offsets = [0, 3, 5] ---> [3, 3]
+ */
+void groupedMedians(
+    std::vector<int> &values, const std::vector<size_t> &offsets, size_t threads, std::vector<double> &medians)
+{
+    medians.resize(offsets.size() - 1);
+    groupedMedians1(values.data(), offsets.data(), medians.size(), threads, medians.data());
+}
+
+/**
+ * @brief same as groupedMedians for quantile @p q (0 <= q <= 1) of every
+ * group: the element at rank max(1, ceil(q * size)) of the group
+ *
+ * Examples:
+ *      values = [5, 1, 3, 2, 4], offsets = [0, 3, 5], q = 1 ---> [5, 4]
+ */
+void groupedQuantiles(
+    std::vector<int>          &values,
+    const std::vector<size_t> &offsets,
+    double                     q,
+    size_t                     threads,
+    std::vector<int>          &quantiles)
+{
+    quantiles.resize(offsets.size() - 1);
+    groupedQuantiles1(values.data(), offsets.data(), quantiles.size(), q, threads, quantiles.data());
+}
+
+/**
+ * @brief calculate the median of values of every key of parallel key/value
+ * arrays (group by key)
+ *
+ * @param keys
+ * @param values - values[i] belongs to keys[i], both are reordered so that
+ * equal keys are contiguous
+ * @param threads - same as for groupedMedians
+ * @param groupKeys - the distinct keys in ascending order
+ * @param medians - medians[g] is the median of values of groupKeys[g]
+ *
+ * Constraints:
+ *      1. keys.size() == values.size()
+ * Examples:
+ *      keys = [7, 2, 7, 2, 7], values = [1, 5, 2, 6, 9] ---> groupKeys = [2, 7],
+ *      medians = [5.5, 2]
+ */
+void groupedMediansByKey(
+    std::vector<int>    &keys,
+    std::vector<int>    &values,
+    size_t               threads,
+    std::vector<int>    &groupKeys,
+    std::vector<double> &medians)
+{
+    auto offsets = std::vector<size_t>{};
+    groupKeys    = groupByKey1(keys, values, offsets);
+    groupedMedians(values, offsets, threads, medians);
+}
+
 // --------------------
 // --------------------
 // --------------------
@@ -48,8 +345,35 @@ const BenchmarkData benchmarksData {
         .add(PivotPolicy::UniformRandom, InputData::SortedArray,             { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
         .add(PivotPolicy::UniformRandom, InputData::ReversedSortedArray,     { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
         .add(PivotPolicy::UniformRandom, InputData::RandomArray,             { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
+
+        .add(PivotPolicy::Introselect, InputData::SortedArray,               { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
+        .add(PivotPolicy::Introselect, InputData::ReversedSortedArray,       { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
+        .add(PivotPolicy::Introselect, InputData::RandomArray,               { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
     .build()
 };
+
+// max weights to benchmark weightedMedian with, weights are uniform in [1, max weight] (feel free to change)
+const std::vector<long long> weightedMedianMaxWeights{ 1LL, 10LL, 100LL };
+
+// series lengths and window lengths to benchmark slidingWindowMedian with (feel free to change)
+const std::vector<long long> slidingWindowMedianNs{ 100000LL };
+const std::vector<long long> slidingWindowMedianWindows{ 100LL, 1000LL, 10000LL };
+
+// numbers of latency samples to benchmark HdrHistogram recording with (feel free to change)
+const std::vector<long long> hdrHistogramNs{ 10000LL, 100000LL, 1000000LL };
+
+// fractions cut from each end for trimmed means in robustStats benchmarks, in percents (feel free to change)
+const std::vector<long long> robustStatsTrimPercents{ 5LL, 25LL };
+
+// image sides, filter radii and thread counts to benchmark medianFilter with (feel free to change)
+const std::vector<long long> medianFilterSides{ 256LL, 1024LL };
+const std::vector<long long> medianFilterRadii{ 1LL, 2LL, 4LL, 16LL };
+const std::vector<long long> medianFilterThreads{ 1LL, 4LL };
+
+// numbers of rows, mean group sizes and thread counts to benchmark groupedMedians with (feel free to change)
+const std::vector<long long> groupedMedianNs{ 1000000LL };
+const std::vector<long long> groupedMedianGroupSizes{ 4LL, 64LL, 4096LL };
+const std::vector<long long> groupedMedianThreads{ 1LL, 4LL };
 // clang-format on
 
 // don't touch
@@ -26,6 +26,244 @@ int quickSelect(std::vector<int>& v, int k, Pivot_f pivotFunction)
     return quickSelect1(v, k, pivotFunction);
 }
 
+/**
+ * @brief same as quickSelect, but @p v is not modified: the selection runs in
+ * @p scratch, which is resized to v.size() and can be reused between calls
+ * without further allocations (see quickSelectConst1 in common.h)
+ */
+int quickSelectConst(const std::vector<int>& v, int k, Pivot_f pivotFunction, std::vector<int>& scratch)
+{
+    return quickSelectConst1(v, k, pivotFunction, scratch);
+}
+
+/**
+ * @brief same as above with the scratch buffer of the calling thread
+ */
+int quickSelectConst(const std::vector<int>& v, int k, Pivot_f pivotFunction)
+{
+    return quickSelectConst1(v, k, pivotFunction, threadLocalScratch());
+}
+
+/**
+ * @brief same as quickSelect, but stops once @p budget element visits are used
+ * up (a partition of m elements costs m)
+ *
+ * @return AnytimeSelection - the exact kth value when the budget allows it,
+ * otherwise the current candidate and a guaranteed range of its rank (see
+ * AnytimeSelection in common.h)
+ */
+AnytimeSelection quickSelectBudgeted(std::vector<int>& v, int k, Pivot_f pivotFunction, size_t budget)
+{
+    return quickSelectBudgeted1(v, k, pivotFunction, budget);
+}
+
+/**
+ * @brief same as quickSelectBudgeted, but limited by a point in time
+ */
+AnytimeSelection quickSelectDeadline(
+    std::vector<int>&                     v,
+    int                                   k,
+    Pivot_f                               pivotFunction,
+    std::chrono::steady_clock::time_point deadline)
+{
+    return quickSelectDeadline1(v, k, pivotFunction, deadline);
+}
+
+/**
+ * @brief same contract as quickSelect, but guaranteed O(n): @p pivotFunction is
+ * used while partitions make progress, median-of-medians pivots take over when
+ * they stall (see introSelect1 in common.h)
+ */
+int introSelect(std::vector<int>& v, int k, Pivot_f pivotFunction)
+{
+    return introSelect1(v, k, pivotFunction);
+}
+
+/**
+ * @brief same contract as quickSelect, Floyd-Rivest sampling selection: two
+ * pivots bracketing rank @p k are picked from a recursive sample, so most of
+ * @p v is discarded after one pass. @p pivotFunction is used for small windows
+ * (see floydRivestSelect1 in common.h)
+ */
+int floydRivestSelect(std::vector<int>& v, int k, Pivot_f pivotFunction)
+{
+    return floydRivestSelect1(v, k, pivotFunction);
+}
+
+/**
+ * @brief same contract as quickSelect, but without a pivot function: rank @p k
+ * is narrowed down with 11-bit digit histograms (see radixSelect1 in common.h)
+ */
+int radixSelect(std::vector<int>& v, int k)
+{
+    return radixSelect1(v, k);
+}
+
+/**
+ * @brief same contract as quickSelect, but the partitioning work is spread over
+ * @p threads threads (see parallelQuickSelect1 in common.h)
+ *
+ * @param threads - at least 1
+ * @param seed - seed of the pivot generator, the same seed gives the same work
+ * @param cutoff - windows smaller than this are finished on the calling thread
+ */
+int parallelQuickSelect(
+    std::vector<int>& v,
+    int               k,
+    int               threads,
+    unsigned          seed,
+    size_t            cutoff)
+{
+    if (threads < 1)
+        throw std::runtime_error{ "parallelQuickSelect: threads should be at least 1" };
+    return parallelQuickSelect1(v, k, threads, seed, cutoff);
+}
+
+/**
+ * @brief kth order statistics of data that is only readable sequentially (e.g. a
+ * file larger than RAM) with a bounded amount of memory
+ *
+ * @param source - SpanSource or Int32FileSource from common.h
+ * @param k - 1 <= k <= source.size()
+ * @param memoryBudget - max number of histogram buckets / buffered elements,
+ * 0 means sqrt(source.size())
+ *
+ * @return int - kth order statistics of @p source (see multiPassSelect1 in
+ * common.h)
+ */
+template <typename Source>
+int multiPassSelect(const Source& source, long long k, size_t memoryBudget)
+{
+    return multiPassSelect1(source, k, memoryBudget);
+}
+
+/**
+ * @brief kth order statistics of the union of @p shards without concatenating
+ * them (see shardedSelect1 in common.h)
+ *
+ * @param shards - elements are reordered inside their shards, empty shards are
+ * allowed
+ * @param k - 1 <= k <= total number of elements
+ * @param threads - 1 processes the shards on the calling thread, more spreads
+ * them over that many threads
+ */
+int shardedSelect(std::vector<std::vector<int>>& shards, long long k, size_t threads)
+{
+    return shardedSelect1(shards, k, threads);
+}
+
+/**
+ * @brief same as quickSelect on @p keys, but every payload array is permuted
+ * together with the keys (struct-of-arrays rows): afterwards rows [0, k) are the
+ * k rows with the smallest keys
+ *
+ * Constraints:
+ *      1. all payloads have keys.size() elements
+ *
+ * @return int - kth order statistics of @p keys
+ */
+template <typename... Payloads>
+int quickSelectWithPayloads(std::vector<int>& keys, int k, Pivot_f pivotFunction, std::vector<Payloads>&... payloads)
+{
+    return quickSelectWithPayloads1(keys, k, pivotFunction, payloads...);
+}
+
+/**
+ * @brief indices of the @p k smallest keys, @p keys stay untouched; the last
+ * returned index points to the kth order statistics
+ *
+ *      keys = [3, 2, 5, 4], k = 2 ---> [1, 0]
+ */
+std::vector<size_t> argSelect(const std::vector<int>& keys, int k, Pivot_f pivotFunction)
+{
+    return argSelect1(keys, k, pivotFunction);
+}
+
+/**
+ * @brief finds several order statistics of @p v at once
+ *
+ * @param v
+ * @param ks - ranks to select, sorted in non-decreasing order
+ * @param pivotFunction - same as for quickSelect
+ *
+ * Constraints:
+ *      1. v.size() > 0
+ *      2. 1 <= ks[i] <= v.size(), ks[i] <= ks[i + 1]
+ *
+ * @return std::vector<int> - i-th element is the ks[i]-th order statistics of @p v
+ *      v = [3, 2, 5, 4],  ks = [1, 2, 4] ---> [2, 3, 5]
+ */
+std::vector<int> multiSelect(std::vector<int>& v, const std::vector<int>& ks, Pivot_f pivotFunction)
+{
+    return multiSelect1(v, ks, pivotFunction);
+}
+
+/**
+ * @brief approximate quantile sketch of @p v (see KllSketch in common.h): every
+ * thread sketches its chunk into a private sketch, they are merged at the end
+ *
+ * @param v
+ * @param threads - number of threads, >= 1
+ * @param k - accuracy parameter, the rank error is O(v.size() / k)
+ *
+ * @return KllSketch - sketch of all elements of @p v, @p v is not modified
+ */
+KllSketch kllSketch(const std::vector<int>& v, size_t threads, size_t k)
+{
+    return parallelKllSketch1(v.data(), v.size(), threads, k);
+}
+
+/**
+ * @brief answer the kth queries of an update/query stream over a multiset that
+ * starts as @p initial, with an OrderStatisticTree (B+ tree with subtree
+ * counts, see common.h): O(log n) per operation instead of O(n) per query for
+ * re-selecting
+ *
+ * @param initial
+ * @param ops - inserts, erases (of values that may be missing, then ignored)
+ * and kth queries with 1-based ranks within the current size
+ *
+ * Examples:
+ *      initial = [5, 1], ops = [insert 3, kth 2, erase 3, kth 2] ---> [3, 5]
+ *
+ * @return std::vector<int> - answers of the kth queries in order
+ */
+std::vector<int> dynamicKth(const std::vector<int>& initial, const std::vector<OrderStatisticOp>& ops)
+{
+    OrderStatisticTree tree{ initial };
+    return orderStatisticStream1(tree, ops);
+}
+
+/**
+ * @brief same as dynamicKth with a FenwickOrderStatistics over the domain
+ * [lo, hi], all values of @p initial and @p ops have to lie in it
+ */
+std::vector<int> dynamicKthFenwick(
+    const std::vector<int>& initial, const std::vector<OrderStatisticOp>& ops, int lo, int hi)
+{
+    FenwickOrderStatistics fenwick{ lo, hi };
+    for (const auto value : initial)
+        fenwick.insert(value);
+    return orderStatisticStream1(fenwick, ops);
+}
+
+/**
+ * @brief build a WaveletMatrix (see common.h) over @p v for repeated range
+ * queries: rangeKth(l, r, k), rangeCount(l, r, lo, hi) and rangeMedian(l, r)
+ * over positions [l, r] in O(log sigma) each, instead of copying the range and
+ * running quickSelect on it
+ *
+ * Examples:
+ *      v = [5, 1, 4, 2, 3]: rangeKth(1, 3, 2) ---> 2, rangeCount(0, 4, 2, 4) ---> 3,
+ *      rangeMedian(0, 3) ---> 3
+ *
+ * @return WaveletMatrix - index of @p v, which is not modified and not referenced
+ */
+WaveletMatrix waveletMatrix(const std::vector<int>& v)
+{
+    return WaveletMatrix{ v };
+}
+
 // --------------------
 // --------------------
 // --------------------
@@ -41,11 +279,53 @@ const BenchmarkData benchmarksData {
         .add(PivotPolicy::Deterministic, InputData::ReversedSortedArray,     { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
         .add(PivotPolicy::Deterministic, InputData::RandomArray,             { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
         
-        .add(PivotPolicy::UniformRandom, InputData::SortedArray,             { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
-        .add(PivotPolicy::UniformRandom, InputData::ReversedSortedArray,     { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
-        .add(PivotPolicy::UniformRandom, InputData::RandomArray,             { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
+        .add(PivotPolicy::UniformRandom, InputData::SortedArray,             { 100LL, 600LL, 1100LL, 1600LL, 2100LL, 10000LL, 100000LL })
+        .add(PivotPolicy::UniformRandom, InputData::ReversedSortedArray,     { 100LL, 600LL, 1100LL, 1600LL, 2100LL, 10000LL, 100000LL })
+        .add(PivotPolicy::UniformRandom, InputData::RandomArray,             { 100LL, 600LL, 1100LL, 1600LL, 2100LL, 10000LL, 100000LL })
+
+        .add(PivotPolicy::Introselect, InputData::SortedArray,               { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
+        .add(PivotPolicy::Introselect, InputData::ReversedSortedArray,       { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
+        .add(PivotPolicy::Introselect, InputData::RandomArray,               { 100LL, 600LL, 1100LL, 1600LL, 2100LL })
+
+        .add(PivotPolicy::FloydRivest, InputData::SortedArray,               { 100LL, 600LL, 1100LL, 1600LL, 2100LL, 10000LL, 100000LL })
+        .add(PivotPolicy::FloydRivest, InputData::ReversedSortedArray,       { 100LL, 600LL, 1100LL, 1600LL, 2100LL, 10000LL, 100000LL })
+        .add(PivotPolicy::FloydRivest, InputData::RandomArray,               { 100LL, 600LL, 1100LL, 1600LL, 2100LL, 10000LL, 100000LL })
     .build()
 };
+
+// lengths of arrays to benchmark radixSelect with, for every input data (feel free to change)
+const std::vector<long long> radixSelectNs{ 100LL, 600LL, 1100LL, 1600LL, 2100LL, 10000LL, 100000LL };
+
+// lengths of arrays and thread counts to benchmark parallelQuickSelect with (feel free to change)
+const std::vector<long long> parallelQuickSelectNs{ 100000LL, 1000000LL, 10000000LL };
+const std::vector<long long> parallelQuickSelectThreads{ 1LL, 2LL, 4LL, 8LL };
+
+// lengths of the files to benchmark multiPassSelect with, the largest one takes 2 GiB
+// of disk space in the temporary directory (feel free to change)
+const std::vector<long long> multiPassSelectNs{ 1LL << 20, 1LL << 26, 1LL << 29 };
+
+// total lengths, shard counts and thread counts to benchmark shardedSelect with (feel free to change)
+const std::vector<long long> shardedSelectNs{ 100000LL, 1000000LL };
+const std::vector<long long> shardedSelectShards{ 1LL, 4LL, 16LL, 64LL };
+const std::vector<long long> shardedSelectThreads{ 1LL, 4LL };
+
+// work budgets of quickSelectBudgeted in percents of the array length (feel free to change)
+const std::vector<long long> anytimeBudgetPercents{ 50LL, 100LL, 150LL, 200LL, 300LL, 400LL, 1000LL };
+
+// numbers of ranks requested per multiSelect call (feel free to change)
+const std::vector<long long> multiSelectRanks{ 1LL, 4LL, 16LL, 64LL };
+
+// accuracy parameters, stream lengths and numbers of merged sketches to benchmark KllSketch with (feel free to change)
+const std::vector<long long> kllSketchKs{ 100LL, 200LL, 800LL };
+const std::vector<long long> kllSketchNs{ 100000LL, 1000000LL };
+const std::vector<long long> kllSketchMerged{ 4LL, 16LL, 64LL };
+// initial sizes and shares of kth queries among stream operations (the rest are inserts
+// and erases in equal parts) to benchmark dynamicKth with (feel free to change)
+const std::vector<long long> dynamicKthNs{ 10000LL, 100000LL, 1000000LL };
+const std::vector<long long> dynamicKthQueryPercents{ 10LL, 50LL, 90LL };
+// array lengths for the wavelet matrix build and queries, and lengths of the queried ranges (feel free to change)
+const std::vector<long long> waveletMatrixNs{ 100000LL, 1000000LL, 10000000LL };
+const std::vector<long long> waveletMatrixRangeLengths{ 100LL, 10000LL, 1000000LL };
 // clang-format on
 
 // don't touch
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include "common.h"
@@ -12,15 +13,18 @@ void quickSort(std::vector<int>& v, int left, int right, Pivot_f pivotFunction)
 }
 
 
+// index of the (lower) median of data[0..n], the window of the Pivot_f contract
 size_t deterministicMedianPivot(int *data, size_t n){
-    std::vector<int> integerVector(data, data + n);
-    return medianDeterministicPivot1(integerVector);
+    std::vector<int> integerVector(data, data + n + 1);
+    const int median = integerVector[introSelectRange(integerVector.data(), n + 1, n / 2, deterministicPivot)];
+    return std::find(data, data + n + 1, median) - data;
 }
 
 size_t uniformRandomMedianPivot(int *data, size_t n)
 {
-    std::vector<int> integerVector(data, data + n);
-    return medianUniformRandomPivot1(integerVector);
+    std::vector<int> integerVector(data, data + n + 1);
+    const int median = integerVector[introSelectRange(integerVector.data(), n + 1, n / 2, uniformRandomPivot)];
+    return std::find(data, data + n + 1, median) - data;
 }
 
 void quickSortSimplePivot(std::vector<int> &v, Pivot_f pivotFunction)
@@ -32,6 +36,16 @@ void quickSortMedianPivot(std::vector<int> &v, Pivot_f pivotFunction)
     quickSort(v, 0, v.size() - 1, pivotFunction);
 }
 
+std::vector<int> topK(std::vector<int> &v, int k, Pivot_f pivotFunction)
+{
+    return topK1(v, k, pivotFunction);
+}
+
+std::vector<int> streamingTopK(const std::vector<int> &v, int k)
+{
+    return topKStream1(SpanSource{ v.data(), v.size() }, k);
+}
+
 // --------------------
 // --------------------
 // --------------------
@@ -62,5 +76,10 @@ const BenchmarkData benchmarksData {
 };
 // clang-format on
 
+// larger lengths for topK benchmarks (UniformRandom pivot, random arrays),
+// k runs over 1, n / 1000, n / 100 and n / 10
+// feel free to change
+const std::vector<long long> topKNs{ 10000LL, 100000LL, 1000000LL };
+
 // don't touch
 #include "utils/quicksort.h"
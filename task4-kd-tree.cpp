@@ -0,0 +1,44 @@
+#include <array>
+#include <vector>
+#include "common.h"
+
+/**
+ * @brief builds a k-d tree over @p points (the tree keeps its own reordered copy)
+ *
+ * @param threads - number of threads the build may use
+ *
+ * @return KdTree<D> tree supporting nearest and range queries
+ */
+template <size_t D>
+KdTree<D> buildKdTree(const std::vector<KdPoint<D>> &points, size_t threads)
+{
+    return KdTree<D>{ points, threads };
+}
+
+/**
+ * @brief point of @p tree closest to @p query, @p tree is not empty
+ */
+template <size_t D>
+KdPoint<D> nearestNeighbour(const KdTree<D> &tree, const KdPoint<D> &query)
+{
+    return tree.points()[tree.nearest(query)];
+}
+
+/**
+ * @brief all points of @p tree inside the box [lo, hi], in no particular order
+ */
+template <size_t D>
+std::vector<KdPoint<D>> rangeQuery(const KdTree<D> &tree, const KdPoint<D> &lo, const KdPoint<D> &hi)
+{
+    std::vector<KdPoint<D>> result;
+    for (const auto index : tree.range(lo, hi))
+        result.push_back(tree.points()[index]);
+    return result;
+}
+
+// numbers of points and build threads to benchmark (feel free to change)
+const std::vector<long long> kdTreeNs{ 1LL << 10, 1LL << 14, 1LL << 17, 1LL << 20 };
+const std::vector<long long> kdTreeThreads{ 1, 2, 4 };
+
+// don't touch
+#include "utils/kd-tree.h"
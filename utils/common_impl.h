@@ -14,6 +14,10 @@ std::ostream &operator<<(std::ostream &strm, PivotPolicy rhs)
         return strm << "MedianDeterministic";
     case PivotPolicy::MedianUniformRandom:
         return strm << "MedianUniformRandom";
+    case PivotPolicy::Introselect:
+        return strm << "Introselect";
+    case PivotPolicy::FloydRivest:
+        return strm << "FloydRivest";
     }
 
     return strm << "Unknown";
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include "common.h"
+#include "internalerror.h"
+#include "main.h"
+
+template <size_t D>
+KdTree<D> buildKdTree(const std::vector<KdPoint<D>> &, size_t);
+template <size_t D>
+KdPoint<D> nearestNeighbour(const KdTree<D> &, const KdPoint<D> &);
+template <size_t D>
+std::vector<KdPoint<D>> rangeQuery(const KdTree<D> &, const KdPoint<D> &, const KdPoint<D> &);
+
+extern const std::vector<long long> kdTreeNs;
+extern const std::vector<long long> kdTreeThreads;
+
+namespace Utils::KdTree
+{
+// queries per benchmark iteration
+constexpr int kQueries = 1000;
+
+struct Test
+{
+    // number of points, coordinates are uniform in [-range, range]
+    int n;
+    int range;
+};
+
+std::ostream &operator<<(std::ostream &strm, const Test &rhs)
+{
+    return strm << "{n = " << rhs.n << ", range = " << rhs.range << "}";
+}
+
+std::vector<Test> getTests()
+{
+    auto tests = std::vector<Test>{};
+
+    for (const auto n : { 0, 1, 2, 3, 7, 100, 1000, 5000 })
+    {
+        // small ranges produce many points sharing coordinates on every axis
+        for (const auto range : { 0, 3, 1000, 1 << 29 })
+            tests.push_back(Test{ n, range });
+    }
+
+    return tests;
+}
+
+template <size_t D>
+std::vector<KdPoint<D>> generatePoints(std::mt19937 &gen, int n, int range)
+{
+    auto distr = std::uniform_int_distribution<int>{ -range, range };
+
+    auto points = std::vector<KdPoint<D>>(n);
+    for (auto &point : points)
+    {
+        for (auto &coordinate : point)
+            coordinate = distr(gen);
+    }
+    return points;
+}
+
+template <size_t D>
+std::string toString(const KdPoint<D> &p)
+{
+    auto strm = std::stringstream{};
+    strm << "(" << p[0];
+    for (size_t i = 1; i < D; ++i)
+        strm << ", " << p[i];
+    strm << ")";
+    return strm.str();
+}
+
+/**
+ * @brief builds n points with @p threads threads, checks the split invariant
+ * of every node and compares nearest/range queries with a linear scan
+ */
+template <size_t D>
+void checkKdTree(const Test &test, size_t threads)
+{
+    auto gen = std::mt19937{ 47 };
+
+    auto       points = generatePoints<D>(gen, test.n, test.range);
+    const auto tree   = ::KdTree<D>{ points, threads, uniformRandomPivot, 64 };
+    const auto &built = tree.points();
+
+    auto sortedPoints = points;
+    auto sortedBuilt  = built;
+    std::sort(sortedPoints.begin(), sortedPoints.end());
+    std::sort(sortedBuilt.begin(), sortedBuilt.end());
+    ASSERT_EQ(sortedPoints, sortedBuilt)
+        << "KdTree lost or changed points, D = " << D << ", test = " << test;
+
+    auto checkSplits = [&](auto &self, size_t l, size_t r, size_t depth) -> void
+    {
+        if (r - l <= 1)
+            return;
+
+        const size_t m    = l + (r - l) / 2;
+        const size_t axis = depth % D;
+        for (size_t i = l; i < r; ++i)
+        {
+            ASSERT_TRUE(i < m ? built[i][axis] <= built[m][axis]
+                              : built[i][axis] >= built[m][axis])
+                << "Point " << toString<D>(built[i]) << " is on the wrong side of "
+                << toString<D>(built[m]) << ", axis = " << axis << ", D = " << D
+                << ", test = " << test;
+        }
+        self(self, l, m, depth + 1);
+        self(self, m + 1, r, depth + 1);
+    };
+    checkSplits(checkSplits, 0, built.size(), 0);
+
+    if (test.n == 0)
+        return;
+
+    const auto queryRange = std::max(test.range, 1) + 2;
+    for (const auto &query : generatePoints<D>(gen, 50, queryRange))
+    {
+        long long expected = std::numeric_limits<long long>::max();
+        for (const auto &p : points)
+            expected = std::min(expected, ::KdTree<D>::distance2(p, query));
+
+        const auto actual = ::nearestNeighbour(tree, query);
+        ASSERT_EQ(::KdTree<D>::distance2(actual, query), expected)
+            << "Wrong nearest neighbour " << toString<D>(actual) << " of "
+            << toString<D>(query) << ", D = " << D << ", test = " << test;
+    }
+
+    for (const auto &corner : generatePoints<D>(gen, 50, queryRange))
+    {
+        auto lo = corner;
+        auto hi = corner;
+        for (size_t axis = 0; axis < D; ++axis)
+            hi[axis] += queryRange / 2;
+
+        auto expected = std::vector<KdPoint<D>>{};
+        for (const auto &p : points)
+        {
+            bool inside = true;
+            for (size_t axis = 0; axis < D; ++axis)
+                inside = inside && lo[axis] <= p[axis] && p[axis] <= hi[axis];
+            if (inside)
+                expected.push_back(p);
+        }
+
+        auto actual = ::rangeQuery(tree, lo, hi);
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        ASSERT_EQ(actual, expected)
+            << "Wrong range query [" << toString<D>(lo) << ", " << toString<D>(hi)
+            << "], D = " << D << ", test = " << test;
+    }
+}
+
+enum class Query
+{
+    Nearest,
+    NearestScan,
+    Range
+};
+
+std::ostream &operator<<(std::ostream &strm, Query rhs)
+{
+    switch (rhs)
+    {
+    case Query::Nearest:
+        return strm << "Nearest";
+    case Query::NearestScan:
+        return strm << "NearestScan";
+    case Query::Range:
+        return strm << "Range";
+    }
+
+    return strm << "Unknown";
+}
+
+/**
+ * @brief builds a tree over state.range(0) random points with state.range(1)
+ * threads
+ */
+template <size_t D>
+static void BM_kdTreeBuild(benchmark::State &state)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n       = static_cast<int>(state.range(0));
+    const auto threads = static_cast<size_t>(state.range(1));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto points = generatePoints<D>(gen, n, 1 << 20);
+        state.ResumeTiming();
+
+        auto tree = ::buildKdTree(points, threads);
+        ::benchmark::DoNotOptimize(tree);
+    }
+}
+
+/**
+ * @brief kQueries queries against a tree over state.range(0) random points:
+ * nearest neighbours (with a linear scan as the baseline) or boxes expected to
+ * hold about 16 points each
+ */
+template <size_t D>
+static void BM_kdTreeQuery(benchmark::State &state, Query query)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    constexpr int range = 1 << 20;
+
+    const auto points = generatePoints<D>(gen, n, range);
+    const auto tree   = ::buildKdTree(points, 1);
+
+    const auto side = static_cast<int>(
+        2.0 * range * std::pow(std::min(16.0 / n, 1.0), 1.0 / D));
+
+    long long found = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const auto queries = generatePoints<D>(gen, kQueries, range);
+        state.ResumeTiming();
+
+        for (const auto &q : queries)
+        {
+            switch (query)
+            {
+            case Query::Nearest:
+            {
+                auto res = ::nearestNeighbour(tree, q);
+                ::benchmark::DoNotOptimize(res);
+                break;
+            }
+            case Query::NearestScan:
+            {
+                auto best = *std::min_element(
+                    points.begin(),
+                    points.end(),
+                    [&](const auto &a, const auto &b) {
+                        return ::KdTree<D>::distance2(a, q) <
+                               ::KdTree<D>::distance2(b, q);
+                    });
+                ::benchmark::DoNotOptimize(best);
+                break;
+            }
+            case Query::Range:
+            {
+                auto hi = q;
+                for (auto &coordinate : hi)
+                    coordinate += side;
+                auto res = ::rangeQuery(tree, q, hi);
+                found += res.size();
+                ::benchmark::DoNotOptimize(res);
+                break;
+            }
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * kQueries);
+    if (query == Query::Range)
+        state.counters["pointsPerQuery"] = benchmark::Counter(
+            static_cast<double>(found) / kQueries, benchmark::Counter::kAvgIterations);
+}
+
+template <size_t D>
+void registerBenchmarks()
+{
+    const auto dimension = (std::stringstream{} << D << "D").str();
+
+    auto build = benchmark::RegisterBenchmark(
+        "kdTree/build/" + dimension, BM_kdTreeBuild<D>);
+    for (const auto &n : ::kdTreeNs)
+    {
+        for (const auto &threads : ::kdTreeThreads)
+            build->Args({ n, threads });
+    }
+    build->UseRealTime();
+
+    for (const auto query : { Query::Nearest, Query::NearestScan, Query::Range })
+    {
+        const auto name =
+            (std::stringstream{} << "kdTree/" << query << "/" << dimension).str();
+
+        auto b = benchmark::RegisterBenchmark(name, BM_kdTreeQuery<D>, query);
+        for (const auto &n : ::kdTreeNs)
+        {
+            // a linear scan over the largest trees takes too long per query batch
+            if (query != Query::NearestScan || n <= (1LL << 17))
+                b->Arg(n);
+        }
+    }
+}
+
+const int kTmp{ []() -> int
+                {
+                    registerBenchmarks<2>();
+                    registerBenchmarks<3>();
+                    registerBenchmarks<4>();
+                    return 0;
+                }() };
+
+class KdTree : public ::testing::TestWithParam<std::tuple<size_t, Test>>
+{
+};
+
+TEST_P(KdTree, Correctness)
+{
+    const auto &[threads, test] = GetParam();
+
+    checkKdTree<2>(test, threads);
+    checkKdTree<3>(test, threads);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SingleThread,
+    KdTree,
+    ::testing::Combine(::testing::ValuesIn({ size_t{ 1 } }), ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    FourThreads,
+    KdTree,
+    ::testing::Combine(::testing::ValuesIn({ size_t{ 4 } }), ::testing::ValuesIn(getTests())));
+
+}    // namespace Utils::KdTree
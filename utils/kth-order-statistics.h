@@ -1,10 +1,16 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <limits>
 #include <ostream>
 #include <random>
 #include <sstream>
+#include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -18,11 +24,71 @@
 #include "main.h"
 
 int quickSelect(std::vector<int> &, int, Pivot_f);
+int quickSelectConst(const std::vector<int> &, int, Pivot_f, std::vector<int> &);
+int quickSelectConst(const std::vector<int> &, int, Pivot_f);
+AnytimeSelection quickSelectBudgeted(std::vector<int> &, int, Pivot_f, size_t);
+AnytimeSelection quickSelectDeadline(
+    std::vector<int> &, int, Pivot_f, std::chrono::steady_clock::time_point);
+int introSelect(std::vector<int> &, int, Pivot_f);
+int floydRivestSelect(std::vector<int> &, int, Pivot_f);
+int radixSelect(std::vector<int> &, int);
+template <typename Source>
+int multiPassSelect(const Source &, long long, size_t);
+int shardedSelect(std::vector<std::vector<int>> &, long long, size_t);
+template <typename... Payloads>
+int quickSelectWithPayloads(std::vector<int> &, int, Pivot_f, std::vector<Payloads> &...);
+std::vector<size_t> argSelect(const std::vector<int> &, int, Pivot_f);
+int parallelQuickSelect(std::vector<int> &, int, int, unsigned, size_t);
+std::vector<int> multiSelect(std::vector<int> &, const std::vector<int> &, Pivot_f);
+std::vector<int> dynamicKth(const std::vector<int> &, const std::vector<OrderStatisticOp> &);
+std::vector<int> dynamicKthFenwick(const std::vector<int> &, const std::vector<OrderStatisticOp> &, int, int);
+WaveletMatrix waveletMatrix(const std::vector<int> &);
+KllSketch kllSketch(const std::vector<int> &, size_t, size_t);
 
-extern const BenchmarkData benchmarksData;
+extern const BenchmarkData           benchmarksData;
+extern const std::vector<long long> radixSelectNs;
+extern const std::vector<long long> parallelQuickSelectNs;
+extern const std::vector<long long> parallelQuickSelectThreads;
+extern const std::vector<long long> multiPassSelectNs;
+extern const std::vector<long long> anytimeBudgetPercents;
+extern const std::vector<long long> shardedSelectNs;
+extern const std::vector<long long> shardedSelectShards;
+extern const std::vector<long long> shardedSelectThreads;
+extern const std::vector<long long> multiSelectRanks;
+extern const std::vector<long long> kllSketchKs;
+extern const std::vector<long long> kllSketchNs;
+extern const std::vector<long long> kllSketchMerged;
+extern const std::vector<long long> dynamicKthNs;
+extern const std::vector<long long> dynamicKthQueryPercents;
+extern const std::vector<long long> waveletMatrixNs;
+extern const std::vector<long long> waveletMatrixRangeLengths;
 
 namespace Utils::KthOrderStatistics
 {
+using QuickSelect_f = int (*)(std::vector<int> &, int, Pivot_f);
+
+QuickSelect_f getQuickSelectF(PivotPolicy pivotPolicy)
+{
+    switch (pivotPolicy)
+    {
+    case PivotPolicy::Deterministic:
+    case PivotPolicy::UniformRandom:
+        return &::quickSelect;
+    case PivotPolicy::Introselect:
+        return &::introSelect;
+    case PivotPolicy::FloydRivest:
+        return &::floydRivestSelect;
+    case PivotPolicy::MedianDeterministic:
+    case PivotPolicy::MedianUniformRandom:
+        // quick sort policies
+        break;
+    }
+
+    throw InternalError{
+        "kth-order-statistics.h: quick select function cannot be nullptr"
+    };
+}
+
 Pivot_f getPivotF(PivotPolicy pivotPolicy)
 {
     Pivot_f res = nullptr;
@@ -35,6 +101,18 @@ Pivot_f getPivotF(PivotPolicy pivotPolicy)
     case PivotPolicy::UniformRandom:
         res = &::uniformRandomPivot;
         break;
+    case PivotPolicy::Introselect:
+        // fast path of introselect, medianOfMediansPivot is used on stalls
+        res = &::deterministicPivot;
+        break;
+    case PivotPolicy::FloydRivest:
+        // finishes windows below kFloydRivestCutoff
+        res = &::uniformRandomPivot;
+        break;
+    case PivotPolicy::MedianDeterministic:
+    case PivotPolicy::MedianUniformRandom:
+        // quick sort policies
+        break;
     }
     if (res == nullptr)
     {
@@ -97,6 +175,13 @@ std::vector<Test> getTests()
     tests.emplace_back(std::vector<int>{ 1, 1, 2 }, 2);
     tests.emplace_back(std::vector<int>{ 1, 1, 2 }, 3);
 
+    for (int k = 1; k <= 5; ++k)
+        tests.emplace_back(std::vector<int>{ max, -1, min, 0, min + 1 }, k);
+    for (int k = 1; k <= 4; ++k)
+        tests.emplace_back(std::vector<int>{ min, max, min, max }, k);
+    tests.emplace_back(std::vector<int>{ max - 100, 0, 1, 10, min + 2, min, max }, 2);
+    tests.emplace_back(std::vector<int>{ max - 100, 0, 1, 10, min + 2, min, max }, 6);
+
     for (int t = 1; t <= 10; ++t)
     {
         auto values = std::vector<int>{};
@@ -124,9 +209,168 @@ std::vector<Test> getTests()
             tests.emplace_back(values, kDistr(gen));
     }
 
+    for (int t = 1; t <= 5; ++t)
+    {
+        int n = t * 50;
+
+        auto values = std::vector<int>{};
+        for (int i = 0; i < n; ++i)
+            values.push_back(i / 3);
+
+        tests.emplace_back(values, 1);
+        tests.emplace_back(values, n / 2);
+        tests.emplace_back(values, n);
+
+        std::reverse(values.begin(), values.end());
+
+        tests.emplace_back(values, 1);
+        tests.emplace_back(values, n / 2);
+        tests.emplace_back(values, n);
+    }
+
+    for (int t = 1; t <= 5; ++t)
+    {
+        int n = t * 1000;
+
+        auto valuesDistr = std::uniform_int_distribution<int>{ -1000, 1000 };
+        auto kDistr      = std::uniform_int_distribution<int>{ 1, n };
+
+        auto values = std::vector<int>{};
+
+        for (int i = 0; i < n; ++i)
+            values.push_back(valuesDistr(gen));
+
+        tests.emplace_back(values, 1);
+        tests.emplace_back(values, n);
+        for (int i = 0; i < 3; ++i)
+            tests.emplace_back(values, kDistr(gen));
+    }
+
+    return tests;
+}
+
+struct MultiSelectTest
+{
+    MultiSelectTest() = delete;
+    MultiSelectTest(std::vector<int> v, std::vector<int> ks)
+    {
+        if (v.empty())
+            throw InternalError{ "MultiSelectTest: v array cannot be empty" };
+        if (!std::is_sorted(ks.begin(), ks.end()))
+            throw InternalError{ "MultiSelectTest: ks should be sorted" };
+        if (!ks.empty() && (ks.front() < 1 || static_cast<size_t>(ks.back()) > v.size()))
+            throw InternalError{ "MultiSelectTest: wrong value for k" };
+
+        values   = v;
+        this->ks = ks;
+
+        for (const auto k : ks)
+        {
+            auto m = v.begin() + k - 1;
+            std::nth_element(v.begin(), m, v.end());
+            kthValues.push_back(*m);
+        }
+    }
+
+    MultiSelectTest(const MultiSelectTest &) = default;
+    MultiSelectTest(MultiSelectTest &&)      = default;
+
+    MultiSelectTest &operator=(const MultiSelectTest &) = default;
+    MultiSelectTest &operator=(MultiSelectTest &&)      = default;
+
+    ~MultiSelectTest() = default;
+
+    std::vector<int> values;
+    std::vector<int> ks;
+
+    std::vector<int> kthValues;
+};
+
+std::vector<MultiSelectTest> getMultiSelectTests()
+{
+    auto tests = std::vector<MultiSelectTest>{};
+
+    tests.emplace_back(std::vector<int>{ 1 }, std::vector<int>{});
+    tests.emplace_back(std::vector<int>{ 1 }, std::vector<int>{ 1 });
+    tests.emplace_back(std::vector<int>{ 4, 2 }, std::vector<int>{ 1, 2 });
+    tests.emplace_back(std::vector<int>{ 4, 2, 7 }, std::vector<int>{ 1, 3 });
+    tests.emplace_back(std::vector<int>{ 4, 2, 7 }, std::vector<int>{ 2, 2, 2 });
+    tests.emplace_back(std::vector<int>{ 1, 1, 2 }, std::vector<int>{ 1, 2, 3 });
+    tests.emplace_back(std::vector<int>{ 3, 2, 5, 4 }, std::vector<int>{ 1, 2, 4 });
+
+    for (int t = 1; t <= 10; ++t)
+    {
+        auto values = std::vector<int>{};
+        values.resize(2 * t, t);
+
+        tests.emplace_back(values, std::vector<int>{ 1, t, 2 * t });
+    }
+
+    auto gen = std::mt19937{ 47 };
+
+    for (int t = 1; t <= 10; ++t)
+    {
+        int n = t * 100;
+
+        auto valuesDistr = std::uniform_int_distribution<int>{ -10, 10 };
+        auto kDistr      = std::uniform_int_distribution<int>{ 1, n };
+
+        auto values = std::vector<int>{};
+
+        for (int i = 0; i < n; ++i)
+            values.push_back(valuesDistr(gen));
+
+        for (int r = 1; r <= 16; r *= 2)
+        {
+            auto ks = std::vector<int>{};
+            for (int i = 0; i < r; ++i)
+                ks.push_back(kDistr(gen));
+            std::sort(ks.begin(), ks.end());
+
+            tests.emplace_back(values, ks);
+        }
+
+        // p50 / p90 / p99 / p999
+        tests.emplace_back(
+            values,
+            std::vector<int>{ (n + 1) / 2,
+                              std::max(1, n * 90 / 100),
+                              std::max(1, n * 99 / 100),
+                              std::max(1, n * 999 / 1000) });
+
+        std::sort(values.begin(), values.end());
+        tests.emplace_back(values, std::vector<int>{ 1, n / 3, n / 2, n });
+    }
+
     return tests;
 }
 
+std::vector<int> generateValues(std::mt19937 &gen, int n, InputData inputData)
+{
+    auto valuesDistr = std::uniform_int_distribution<int>{ -1000, 1000 };
+
+    auto values = std::vector<int>{};
+    values.reserve(n);
+
+    for (int i = 0; i < n; ++i)
+        values.push_back(valuesDistr(gen));
+
+    switch (inputData)
+    {
+    case InputData::RandomArray:
+        break;
+    case InputData::SortedArray:
+        std::sort(values.begin(), values.end());
+        break;
+    case InputData::ReversedSortedArray:
+        std::sort(values.begin(), values.end());
+        std::reverse(values.begin(), values.end());
+        break;
+    }
+
+    return values;
+}
+
 static void BM_kthOrderStatistics(
     benchmark::State &state,
     PivotPolicy       pivotPolicy,
@@ -138,135 +382,1949 @@ static void BM_kthOrderStatistics(
     if (n <= 0)
         throw InternalError{ "BM_impl: n should be positive" };
 
-    auto valuesDistr = std::uniform_int_distribution<int>{ -1000, 1000 };
-    auto kDistr      = std::uniform_int_distribution<int>{ 1, n };
+    auto kDistr = std::uniform_int_distribution<int>{ 1, n };
 
-    Pivot_f pivot = getPivotF(pivotPolicy);
+    QuickSelect_f quickSelect = getQuickSelectF(pivotPolicy);
+    Pivot_f       pivot       = getPivotF(pivotPolicy);
 
     for (auto _ : state)
     {
         state.PauseTiming();
 
-        auto values = std::vector<int>{};
-        values.reserve(n);
+        auto       values = generateValues(gen, n, inputData);
+        const auto k      = kDistr(gen);
 
-        for (int i = 0; i < n; ++i)
-            values.push_back(valuesDistr(gen));
+        state.ResumeTiming();
+
+        auto res = quickSelect(values, k, pivot);
+        ::benchmark::DoNotOptimize(res);
+    }
+}
+
+/**
+ * @brief quickSelectConst on a fixed input with a thread-local scratch buffer,
+ * or (@p copyThenSelect) the usual copy of the input followed by quickSelect
+ */
+static void BM_quickSelectConst(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData,
+    bool              copyThenSelect)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    auto kDistr = std::uniform_int_distribution<int>{ 1, n };
 
-        switch (inputData)
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    const auto values = generateValues(gen, n, inputData);
+
+    for (auto _ : state)
+    {
+        const auto k = kDistr(gen);
+
+        if (copyThenSelect)
         {
-        case InputData::RandomArray:
-            break;
-        case InputData::SortedArray:
-            std::sort(values.begin(), values.end());
-            break;
-        case InputData::ReversedSortedArray:
-            std::sort(values.begin(), values.end());
-            std::reverse(values.begin(), values.end());
-            break;
+            auto copy = values;
+            auto res  = ::quickSelect(copy, k, pivot);
+            ::benchmark::DoNotOptimize(res);
+        }
+        else
+        {
+            auto res = ::quickSelectConst(values, k, pivot);
+            ::benchmark::DoNotOptimize(res);
         }
+    }
+}
 
-        const auto k = kDistr(gen);
+/**
+ * @brief quickSelectBudgeted with a budget of state.range(1) percent of n
+ * element visits. Reports the average distance between k and the rank range of
+ * the returned value (rankError) and the average guaranteed bound
+ * rankHigh - rankLow (rankBound), so both can be plotted against the budget.
+ */
+static void BM_quickSelectBudgeted(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n             = static_cast<int>(state.range(0));
+    const auto budgetPercent = static_cast<size_t>(state.range(1));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    auto kDistr = std::uniform_int_distribution<int>{ 1, n };
+
+    Pivot_f      pivot  = getPivotF(pivotPolicy);
+    const size_t budget = n * budgetPercent / 100;
+
+    double rankError = 0;
+    double rankBound = 0;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto       values = generateValues(gen, n, inputData);
+        const auto k      = kDistr(gen);
 
         state.ResumeTiming();
 
-        auto res = ::quickSelect(values, k, pivot);
+        auto res = ::quickSelectBudgeted(values, k, pivot, budget);
         ::benchmark::DoNotOptimize(res);
+
+        state.PauseTiming();
+
+        const auto less = std::count_if(
+            values.begin(), values.end(), [&](int x) { return x < res.value; });
+        const auto lessOrEqual = std::count_if(
+            values.begin(), values.end(), [&](int x) { return x <= res.value; });
+
+        if (k <= less)
+            rankError += less + 1 - k;
+        else if (k > lessOrEqual)
+            rankError += k - lessOrEqual;
+        rankBound += res.rankHigh - res.rankLow;
+
+        state.ResumeTiming();
     }
+
+    state.counters["rankError"] =
+        benchmark::Counter(rankError, benchmark::Counter::kAvgIterations);
+    state.counters["rankBound"] =
+        benchmark::Counter(rankBound, benchmark::Counter::kAvgIterations);
 }
 
-void registerBenchmarks()
+enum class RowLayout
 {
-    const auto &data = ::benchmarksData.getData();
+    StructOfArrays,
+    ArrayOfStructs,
+    Indices
+};
 
-    for (const auto pivotPolicy :
-         { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+std::ostream &operator<<(std::ostream &strm, RowLayout rhs)
+{
+    switch (rhs)
     {
-        for (const auto inputData : { InputData::SortedArray,
-                                      InputData::ReversedSortedArray,
-                                      InputData::RandomArray })
-        {
-            const auto name =
-                (std::stringstream{} << "kthOrderStatistics/" << pivotPolicy
-                                     << "Pivot/" << inputData)
-                    .str();
+    case RowLayout::StructOfArrays:
+        return strm << "SoA";
+    case RowLayout::ArrayOfStructs:
+        return strm << "AoS";
+    case RowLayout::Indices:
+        return strm << "Indices";
+    }
 
-            const auto key = std::make_pair(
-                static_cast<::PivotPolicy>(pivotPolicy),
-                static_cast<::InputData>(inputData));
+    return strm << "Unknown";
+}
 
-            const auto it = data.find(key);
-            if (it == data.end())
-                continue;
+template <int W>
+struct Row
+{
+    int key;
+    int payload[W];
+};
 
-            auto b = benchmark::RegisterBenchmark(
-                name, BM_kthOrderStatistics, pivotPolicy, inputData);
+/**
+ * @brief selects the kth of state.range(0) rows made of a key and W int
+ * payload columns, stored as W + 1 arrays (quickSelectWithPayloads), as an
+ * array of Row<W> (quickSelectRows1) or as keys only with argSelect returning
+ * row indices
+ */
+template <int W>
+static void BM_payloadSelect(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData,
+    RowLayout         layout)
+{
+    auto gen = std::mt19937{ 47 };
 
-            for (const auto &n : it->second)
-            {
-                b->Arg(n);
-            }
-        }
-    }
-}
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
 
-const int kTmp{ []() -> int
-                {
-                    registerBenchmarks();
-                    return 0;
-                }() };
+    auto kDistr = std::uniform_int_distribution<int>{ 1, n };
 
-class KthOrderStatistics
-    : public ::testing::TestWithParam<std::tuple<PivotPolicy, Test>>
-{
-protected:
-    void SetUp() override
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    for (auto _ : state)
     {
-        const auto &[testPivotPolicy, test] = GetParam();
+        state.PauseTiming();
 
-        auto shouldBeSkipped = true;
+        auto       keys = generateValues(gen, n, inputData);
+        const auto k    = kDistr(gen);
 
-        for (const auto &[key, val] : ::benchmarksData.getData())
+        auto payloads = std::array<std::vector<int>, W>{};
+        auto rows     = std::vector<Row<W>>{};
+        switch (layout)
         {
-            const auto &[pivotPolicy, inputData] = key;
-
-            if (pivotPolicy == testPivotPolicy)
-                shouldBeSkipped = false;
+        case RowLayout::StructOfArrays:
+            for (auto &payload : payloads)
+                payload.assign(n, 1);
+            break;
+        case RowLayout::ArrayOfStructs:
+            rows.resize(n);
+            for (int i = 0; i < n; ++i)
+                rows[i].key = keys[i];
+            break;
+        case RowLayout::Indices:
+            break;
         }
 
-        if (shouldBeSkipped)
+        state.ResumeTiming();
+
+        switch (layout)
         {
-            GTEST_SKIP();
+        case RowLayout::StructOfArrays:
+        {
+            auto res = std::apply(
+                [&](auto &...payload)
+                { return ::quickSelectWithPayloads(keys, k, pivot, payload...); },
+                payloads);
+            ::benchmark::DoNotOptimize(res);
+            break;
+        }
+        case RowLayout::ArrayOfStructs:
+        {
+            auto res = ::quickSelectRows1(rows, k, pivot);
+            ::benchmark::DoNotOptimize(res);
+            break;
+        }
+        case RowLayout::Indices:
+        {
+            auto res = ::argSelect(keys, k, pivot);
+            ::benchmark::DoNotOptimize(res);
+            break;
+        }
         }
     }
-};
+}
 
-TEST_P(KthOrderStatistics, Correctness)
+static void BM_radixSelect(benchmark::State &state, InputData inputData)
 {
-    const auto &[pivotPolicy, test] = GetParam();
+    auto gen = std::mt19937{ 47 };
 
-    Pivot_f pivot  = getPivotF(pivotPolicy);
-    auto    values = test.values;
-    auto    k      = test.k;
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
 
-    const auto actual = ::quickSelect(values, k, pivot);
+    auto kDistr = std::uniform_int_distribution<int>{ 1, n };
 
-    ASSERT_EQ(actual, test.kthValue)
-        << "Wrong kth value: PivotPolicy=" << pivotPolicy << ", "
-        << "k = " << test.k << ", v = " << toString(test.values);
-}
+    for (auto _ : state)
+    {
+        state.PauseTiming();
 
-INSTANTIATE_TEST_SUITE_P(
-    DeterministicPivot,
-    KthOrderStatistics,
-    ::testing::Combine(
+        auto       values = generateValues(gen, n, inputData);
+        const auto k      = kDistr(gen);
+
+        state.ResumeTiming();
+
+        auto res = ::radixSelect(values, k);
+        ::benchmark::DoNotOptimize(res);
+    }
+}
+
+/**
+ * @brief parallelQuickSelect over state.range(0) elements on state.range(1)
+ * threads
+ */
+static void BM_parallelQuickSelect(benchmark::State &state, InputData inputData)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n       = static_cast<int>(state.range(0));
+    const auto threads = static_cast<int>(state.range(1));
+    if (n <= 0 || threads <= 0)
+        throw InternalError{ "BM_impl: n and threads should be positive" };
+
+    auto kDistr = std::uniform_int_distribution<int>{ 1, n };
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto       values = generateValues(gen, n, inputData);
+        const auto k      = kDistr(gen);
+
+        state.ResumeTiming();
+
+        auto res = ::parallelQuickSelect(
+            values, k, threads, 47, ::kParallelQuickSelectCutoff);
+        ::benchmark::DoNotOptimize(res);
+    }
+}
+
+void writeInt32File(const std::filesystem::path &path, const std::vector<int> &values)
+{
+    std::ofstream out{ path, std::ios::binary };
+    out.write(
+        reinterpret_cast<const char *>(values.data()),
+        values.size() * sizeof(int32_t));
+    if (!out)
+        throw InternalError{ "cannot write " + path.string() };
+}
+
+/**
+ * @brief path in the temporary directory that concurrent runs do not share:
+ * @p stem followed by a random suffix
+ */
+std::filesystem::path uniqueTempPath(const std::string &stem)
+{
+    auto device = std::random_device{};
+    return std::filesystem::temp_directory_path() /
+           ((std::stringstream{} << stem << "-" << std::hex << device() << device() << ".bin").str());
+}
+
+/**
+ * @brief input file of BM_multiPassSelect: kept while the benchmark function
+ * is called again for the same (inputData, n), removed when the arguments
+ * change and when the program exits
+ */
+struct MultiPassSelectFile
+{
+    ~MultiPassSelectFile() { remove(); }
+
+    void remove()
+    {
+        if (path.empty())
+            return;
+        auto error = std::error_code{};
+        std::filesystem::remove(path, error);
+        path.clear();
+    }
+
+    InputData             inputData = InputData::RandomArray;
+    long long             n         = 0;
+    std::filesystem::path path;
+};
+
+/**
+ * @brief multiPassSelect over a file of state.range(0) ints in the temporary
+ * directory; the file is generated block by block (sorted inputs are ramps
+ * over the whole int range), so its size is not limited by RAM. It is written
+ * once per (inputData, n), not on every call of the benchmark function.
+ */
+static void BM_multiPassSelect(benchmark::State &state, InputData inputData)
+{
+    static auto file = MultiPassSelectFile{};
+
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<long long>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    const auto &path = file.path;
+    if (path.empty() || file.inputData != inputData || file.n != n)
+    {
+        file.remove();
+        file.inputData = inputData;
+        file.n         = n;
+        file.path      = uniqueTempPath(
+            (std::stringstream{} << "multiPassSelect-" << inputData << "-" << n).str());
+
+        auto valuesDistr = std::uniform_int_distribution<int>{
+            std::numeric_limits<int>::min(), std::numeric_limits<int>::max()
+        };
+        const auto step = static_cast<double>(std::numeric_limits<uint32_t>::max()) / n;
+
+        std::ofstream out{ path, std::ios::binary };
+        auto          block = std::vector<int>{};
+        for (long long i = 0; i < n;)
+        {
+            block.clear();
+            for (; i < n && block.size() < (1 << 16); ++i)
+            {
+                const auto ramp = static_cast<int64_t>(i * step) +
+                                  std::numeric_limits<int>::min();
+                switch (inputData)
+                {
+                case InputData::RandomArray:
+                    block.push_back(valuesDistr(gen));
+                    break;
+                case InputData::SortedArray:
+                    block.push_back(static_cast<int>(ramp));
+                    break;
+                case InputData::ReversedSortedArray:
+                    block.push_back(static_cast<int>(-1 - ramp));
+                    break;
+                }
+            }
+            out.write(
+                reinterpret_cast<const char *>(block.data()),
+                block.size() * sizeof(int32_t));
+        }
+        if (!out)
+            throw InternalError{ "cannot write " + path.string() };
+    }
+
+    auto kDistr = std::uniform_int_distribution<long long>{ 1, n };
+
+    const auto source = Int32FileSource{ path };
+
+    for (auto _ : state)
+    {
+        auto res = ::multiPassSelect(source, kDistr(gen), 0);
+        ::benchmark::DoNotOptimize(res);
+    }
+}
+
+/**
+ * @brief splits @p values into @p count shards; with @p skewed every shard gets
+ * half of what is left (the last one takes the rest), otherwise they are
+ * equally sized
+ */
+std::vector<std::vector<int>>
+    splitIntoShards(const std::vector<int> &values, int count, bool skewed)
+{
+    auto shards = std::vector<std::vector<int>>(count);
+
+    size_t begin = 0;
+    for (int s = 0; s < count; ++s)
+    {
+        const size_t left = values.size() - begin;
+        const size_t size = s + 1 == count ? left
+                            : skewed       ? left / 2
+                                           : left / (count - s);
+
+        shards[s].assign(values.begin() + begin, values.begin() + begin + size);
+        begin += size;
+    }
+
+    return shards;
+}
+
+/**
+ * @brief shardedSelect over state.range(0) elements split into state.range(1)
+ * shards (equally sized or @p skewed, see splitIntoShards) on state.range(2)
+ * threads
+ */
+static void
+    BM_shardedSelect(benchmark::State &state, InputData inputData, bool skewed)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n       = static_cast<int>(state.range(0));
+    const auto count   = static_cast<int>(state.range(1));
+    const auto threads = static_cast<int>(state.range(2));
+    if (n <= 0 || count <= 0 || threads <= 0)
+        throw InternalError{ "BM_impl: n, shards and threads should be positive" };
+
+    auto kDistr = std::uniform_int_distribution<int>{ 1, n };
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto       shards = splitIntoShards(generateValues(gen, n, inputData), count, skewed);
+        const auto k      = kDistr(gen);
+
+        state.ResumeTiming();
+
+        auto res = ::shardedSelect(shards, k, threads);
+        ::benchmark::DoNotOptimize(res);
+    }
+}
+
+/**
+ * @brief selects state.range(1) evenly spaced ranks of an array of
+ * state.range(0) elements, either with one multiSelect call or (@p perRank)
+ * with one quickSelect call per rank as a baseline
+ */
+static void BM_multiSelect(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData,
+    bool              perRank)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    const auto r = static_cast<int>(state.range(1));
+    if (n <= 0 || r <= 0)
+        throw InternalError{ "BM_impl: n and number of ranks should be positive" };
+
+    auto ks = std::vector<int>{};
+    for (int i = 0; i < r; ++i)
+        ks.push_back(std::max(1, static_cast<int>((i + 1LL) * n / (r + 1))));
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto values = generateValues(gen, n, inputData);
+
+        state.ResumeTiming();
+
+        if (perRank)
+        {
+            for (const auto k : ks)
+            {
+                auto res = ::quickSelect(values, k, pivot);
+                ::benchmark::DoNotOptimize(res);
+            }
+        }
+        else
+        {
+            auto res = ::multiSelect(values, ks, pivot);
+            ::benchmark::DoNotOptimize(res);
+        }
+    }
+}
+
+/**
+ * @brief state.range(0) updates of a KllSketch with k = state.range(1)
+ * (quantiles = true: plus the queries for p1/p50/p99), compare with
+ * BM_kthOrderStatistics for the cost of one exact answer
+ */
+static void BM_kllSketchUpdate(benchmark::State &state, bool quantiles)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    const auto k = static_cast<size_t>(state.range(1));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const auto values = generateValues(gen, n, InputData::RandomArray);
+        state.ResumeTiming();
+
+        auto sketch = KllSketch{ k };
+        for (const auto value : values)
+            sketch.update(value);
+
+        if (quantiles)
+        {
+            for (const auto q : { 0.01, 0.5, 0.99 })
+            {
+                auto res = sketch.quantile(q);
+                ::benchmark::DoNotOptimize(res);
+            }
+        }
+        ::benchmark::DoNotOptimize(sketch);
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**
+ * @brief rollup: merges state.range(0) sketches (k = state.range(1)) of
+ * 100000 values each into one
+ */
+static void BM_kllSketchMerge(benchmark::State &state)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto count = static_cast<int>(state.range(0));
+    const auto k     = static_cast<size_t>(state.range(1));
+    if (count <= 0)
+        throw InternalError{ "BM_impl: number of sketches should be positive" };
+
+    auto sketches = std::vector<KllSketch>{};
+    for (int i = 0; i < count; ++i)
+        sketches.push_back(kllSketch(generateValues(gen, 100000, InputData::RandomArray), 1, k));
+
+    for (auto _ : state)
+    {
+        auto rollup = KllSketch{ k };
+        for (const auto &sketch : sketches)
+            rollup.merge(sketch);
+        ::benchmark::DoNotOptimize(rollup);
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+/**
+ * @brief kllSketch of state.range(0) values on state.range(1) threads
+ * (k = 200), including the merge of the thread-local sketches
+ */
+static void BM_kllSketchParallel(benchmark::State &state)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n       = static_cast<int>(state.range(0));
+    const auto threads = static_cast<size_t>(state.range(1));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    const auto values = generateValues(gen, n, InputData::RandomArray);
+
+    for (auto _ : state)
+    {
+        auto sketch = kllSketch(values, threads, 200);
+        ::benchmark::DoNotOptimize(sketch);
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**
+ * @brief stream of @p count operations on a multiset initially holding
+ * @p initial: kth queries (uniform rank) with probability @p queryPercent %,
+ * the rest inserts of values uniform in [0, domain) and erases of present
+ * values in equal parts
+ */
+std::vector<OrderStatisticOp> generateOrderStatisticOps(
+    std::mt19937 &gen, std::vector<int> live, int count, int queryPercent, int domain)
+{
+    auto percent = std::uniform_int_distribution<int>{ 0, 99 };
+    auto values  = std::uniform_int_distribution<int>{ 0, domain - 1 };
+
+    auto ops = std::vector<OrderStatisticOp>{};
+    for (int i = 0; i < count; ++i)
+    {
+        const int roll = percent(gen);
+        if (roll < queryPercent && !live.empty())
+        {
+            const auto rank = std::uniform_int_distribution<size_t>{ 1, live.size() }(gen);
+            ops.push_back({ OrderStatisticOp::Kind::Kth, static_cast<int>(rank) });
+        }
+        else if (roll % 2 == 0 && !live.empty())
+        {
+            const auto at = std::uniform_int_distribution<size_t>{ 0, live.size() - 1 }(gen);
+            ops.push_back({ OrderStatisticOp::Kind::Erase, live[at] });
+            std::swap(live[at], live.back());
+            live.pop_back();
+        }
+        else
+        {
+            live.push_back(values(gen));
+            ops.push_back({ OrderStatisticOp::Kind::Insert, live.back() });
+        }
+    }
+    return ops;
+}
+
+/**
+ * @brief the multiset as an unordered vector, every kth query re-selects
+ * with quickSelect: the O(n) per query baseline for the containers in common.h
+ */
+class QuickSelectMultiset
+{
+public:
+    explicit QuickSelectMultiset(std::vector<int> values) : _values{ std::move(values) } {}
+
+    void insert(int value) { _values.push_back(value); }
+
+    bool erase(int value)
+    {
+        const auto it = std::find(_values.begin(), _values.end(), value);
+        if (it == _values.end())
+            return false;
+        *it = _values.back();
+        _values.pop_back();
+        return true;
+    }
+
+    int kth(size_t k) { return ::quickSelect(_values, static_cast<int>(k), uniformRandomPivot); }
+
+private:
+    std::vector<int> _values;
+};
+
+enum class DynamicKthMethod
+{
+    BTree,
+    Fenwick,
+    QuickSelect,
+};
+
+// operations per iteration of BM_dynamicKth
+constexpr int kDynamicKthOps = 2000;
+
+/**
+ * @brief kDynamicKthOps operations with state.range(1) % kth queries on a
+ * multiset of state.range(0) values uniform in [0, 4 * state.range(0)); the
+ * setup of the container is not timed
+ */
+static void BM_dynamicKth(benchmark::State &state, DynamicKthMethod method)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n            = static_cast<int>(state.range(0));
+    const auto queryPercent = static_cast<int>(state.range(1));
+    const auto domain       = 4 * n;
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    auto initial = std::vector<int>{};
+    auto values  = std::uniform_int_distribution<int>{ 0, domain - 1 };
+    for (int i = 0; i < n; ++i)
+        initial.push_back(values(gen));
+
+    const auto ops = generateOrderStatisticOps(gen, initial, kDynamicKthOps, queryPercent, domain);
+
+    for (auto _ : state)
+    {
+        switch (method)
+        {
+        case DynamicKthMethod::BTree:
+        {
+            state.PauseTiming();
+            auto tree = OrderStatisticTree{ initial };
+            state.ResumeTiming();
+            auto res = orderStatisticStream1(tree, ops);
+            ::benchmark::DoNotOptimize(res.data());
+            break;
+        }
+        case DynamicKthMethod::Fenwick:
+        {
+            state.PauseTiming();
+            auto fenwick = FenwickOrderStatistics{ 0, domain - 1 };
+            for (const auto value : initial)
+                fenwick.insert(value);
+            state.ResumeTiming();
+            auto res = orderStatisticStream1(fenwick, ops);
+            ::benchmark::DoNotOptimize(res.data());
+            break;
+        }
+        case DynamicKthMethod::QuickSelect:
+        {
+            state.PauseTiming();
+            auto multiset = QuickSelectMultiset{ initial };
+            state.ResumeTiming();
+            auto res = orderStatisticStream1(multiset, ops);
+            ::benchmark::DoNotOptimize(res.data());
+            break;
+        }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * kDynamicKthOps);
+}
+
+/**
+ * @brief state.range(0) values uniform over all ints, or (smallDomain = true)
+ * in [-1000, 1000], for the wavelet matrix benchmarks and tests
+ */
+std::vector<int> generateWaveletValues(std::mt19937 &gen, int n, bool smallDomain)
+{
+    auto distr = smallDomain ? std::uniform_int_distribution<int>{ -1000, 1000 }
+                             : std::uniform_int_distribution<int>{ std::numeric_limits<int>::min(),
+                                                                   std::numeric_limits<int>::max() };
+    auto values = std::vector<int>{};
+    values.reserve(n);
+    for (int i = 0; i < n; ++i)
+        values.push_back(distr(gen));
+    return values;
+}
+
+/**
+ * @brief waveletMatrix build over state.range(0) values, reports the index
+ * size per element
+ */
+static void BM_waveletMatrixBuild(benchmark::State &state, bool smallDomain)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    const auto values = generateWaveletValues(gen, n, smallDomain);
+
+    size_t bytes = 0;
+    for (auto _ : state)
+    {
+        auto index = waveletMatrix(values);
+        bytes      = index.memoryBytes();
+        ::benchmark::DoNotOptimize(index);
+    }
+
+    state.counters["bytesPerElement"] = static_cast<double>(bytes) / n;
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+enum class RangeQuery
+{
+    Kth,
+    Count,
+    Median,
+};
+
+// queries per iteration of BM_rangeQuery
+constexpr int kRangeQueries = 1000;
+
+/**
+ * @brief kRangeQueries queries over random ranges of state.range(1) positions
+ * of state.range(0) full-range values: on a WaveletMatrix built beforehand,
+ * or (copyAndSelect = true) by copying the range and running quickSelect on
+ * it (a scan for Count)
+ */
+static void BM_rangeQuery(benchmark::State &state, RangeQuery query, bool copyAndSelect)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n      = static_cast<size_t>(state.range(0));
+    const auto length = static_cast<size_t>(state.range(1));
+    if (length == 0 || length > n)
+        throw InternalError{ "BM_impl: range length should be in [1, n]" };
+
+    const auto values = generateWaveletValues(gen, n, false);
+    const auto index  = waveletMatrix(values);
+
+    struct Query
+    {
+        size_t l;
+        size_t k;
+        int    lo;
+        int    hi;
+    };
+    auto queries = std::vector<Query>{};
+    for (int i = 0; i < kRangeQueries; ++i)
+    {
+        const auto l = std::uniform_int_distribution<size_t>{ 0, n - length }(gen);
+        const auto k = std::uniform_int_distribution<size_t>{ 1, length }(gen);
+        auto       a = values[std::uniform_int_distribution<size_t>{ 0, n - 1 }(gen)];
+        auto       b = values[std::uniform_int_distribution<size_t>{ 0, n - 1 }(gen)];
+        queries.push_back({ l, k, std::min(a, b), std::max(a, b) });
+    }
+
+    auto slice = std::vector<int>{};
+
+    for (auto _ : state)
+    {
+        long long checksum = 0;
+        for (const auto &[l, k, lo, hi] : queries)
+        {
+            const auto r = l + length - 1;
+            if (!copyAndSelect)
+            {
+                switch (query)
+                {
+                case RangeQuery::Kth:
+                    checksum += index.rangeKth(l, r, k);
+                    break;
+                case RangeQuery::Count:
+                    checksum += index.rangeCount(l, r, lo, hi);
+                    break;
+                case RangeQuery::Median:
+                    checksum += static_cast<long long>(index.rangeMedian(l, r));
+                    break;
+                }
+                continue;
+            }
+
+            if (query == RangeQuery::Count)
+            {
+                checksum += std::count_if(
+                    values.begin() + l, values.begin() + r + 1, [&](int value) { return lo <= value && value <= hi; });
+                continue;
+            }
+
+            slice.assign(values.begin() + l, values.begin() + r + 1);
+            if (query == RangeQuery::Kth)
+            {
+                checksum += ::quickSelect(slice, static_cast<int>(k), uniformRandomPivot);
+                continue;
+            }
+            const long long lower = ::quickSelect(slice, static_cast<int>((length + 1) / 2), uniformRandomPivot);
+            const long long upper =
+                length % 2 == 1 ? lower : *std::min_element(slice.begin() + length / 2, slice.end());
+            checksum += static_cast<long long>((lower + upper) / 2.0);
+        }
+        ::benchmark::DoNotOptimize(checksum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * kRangeQueries);
+}
+
+void registerBenchmarks()
+{
+    const auto &data = ::benchmarksData.getData();
+
+    for (const auto pivotPolicy : { PivotPolicy::Deterministic,
+                                    PivotPolicy::UniformRandom,
+                                    PivotPolicy::Introselect,
+                                    PivotPolicy::FloydRivest })
+    {
+        for (const auto inputData : { InputData::SortedArray,
+                                      InputData::ReversedSortedArray,
+                                      InputData::RandomArray })
+        {
+            const auto name =
+                (std::stringstream{} << "kthOrderStatistics/" << pivotPolicy
+                                     << "Pivot/" << inputData)
+                    .str();
+
+            const auto key = std::make_pair(
+                static_cast<::PivotPolicy>(pivotPolicy),
+                static_cast<::InputData>(inputData));
+
+            const auto it = data.find(key);
+            if (it == data.end())
+                continue;
+
+            auto b = benchmark::RegisterBenchmark(
+                name, BM_kthOrderStatistics, pivotPolicy, inputData);
+
+            for (const auto &n : it->second)
+            {
+                b->Arg(n);
+            }
+        }
+    }
+
+    for (const auto pivotPolicy :
+         { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+    {
+        for (const auto inputData : { InputData::SortedArray,
+                                      InputData::ReversedSortedArray,
+                                      InputData::RandomArray })
+        {
+            const auto key = std::make_pair(
+                static_cast<::PivotPolicy>(pivotPolicy),
+                static_cast<::InputData>(inputData));
+
+            const auto it = data.find(key);
+            if (it == data.end())
+                continue;
+
+            const auto name =
+                (std::stringstream{} << "quickSelectBudgeted/" << pivotPolicy
+                                     << "Pivot/" << inputData)
+                    .str();
+
+            auto b = benchmark::RegisterBenchmark(
+                name, BM_quickSelectBudgeted, pivotPolicy, inputData);
+
+            for (const auto &n : it->second)
+            {
+                for (const auto &budgetPercent : ::anytimeBudgetPercents)
+                    b->Args({ n, budgetPercent });
+            }
+
+            for (const auto layout : { RowLayout::StructOfArrays,
+                                       RowLayout::ArrayOfStructs,
+                                       RowLayout::Indices })
+            {
+                const auto name = [&](int payloadColumns)
+                {
+                    return (std::stringstream{}
+                            << "payloadSelect/" << pivotPolicy << "Pivot/" << inputData
+                            << "/" << layout << "/Payload" << payloadColumns)
+                        .str();
+                };
+
+                auto narrow = benchmark::RegisterBenchmark(
+                    name(1), BM_payloadSelect<1>, pivotPolicy, inputData, layout);
+                auto wide = benchmark::RegisterBenchmark(
+                    name(7), BM_payloadSelect<7>, pivotPolicy, inputData, layout);
+
+                for (const auto &n : it->second)
+                {
+                    narrow->Arg(n);
+                    wide->Arg(n);
+                }
+            }
+
+            for (const auto copyThenSelect : { false, true })
+            {
+                const auto name =
+                    (std::stringstream{}
+                     << "quickSelectConst/" << pivotPolicy << "Pivot/" << inputData
+                     << (copyThenSelect ? "/CopyThenSelect" : ""))
+                        .str();
+
+                auto b = benchmark::RegisterBenchmark(
+                    name, BM_quickSelectConst, pivotPolicy, inputData, copyThenSelect);
+
+                for (const auto &n : it->second)
+                {
+                    b->Arg(n);
+                }
+            }
+        }
+    }
+
+    for (const auto inputData : { InputData::SortedArray,
+                                  InputData::ReversedSortedArray,
+                                  InputData::RandomArray })
+    {
+        for (const auto skewed : { false, true })
+        {
+            const auto name = (std::stringstream{}
+                               << "kthOrderStatistics/ShardedSelect/" << inputData
+                               << (skewed ? "/Skewed" : "/Uniform"))
+                                  .str();
+
+            auto b = benchmark::RegisterBenchmark(
+                name, BM_shardedSelect, inputData, skewed);
+
+            for (const auto &n : ::shardedSelectNs)
+            {
+                for (const auto &count : ::shardedSelectShards)
+                {
+                    for (const auto &threads : ::shardedSelectThreads)
+                        b->Args({ n, count, threads });
+                }
+            }
+            b->UseRealTime();
+        }
+    }
+
+    for (const auto inputData : { InputData::SortedArray,
+                                  InputData::ReversedSortedArray,
+                                  InputData::RandomArray })
+    {
+        const auto name =
+            (std::stringstream{} << "kthOrderStatistics/MultiPassSelect/" << inputData)
+                .str();
+
+        auto b = benchmark::RegisterBenchmark(name, BM_multiPassSelect, inputData);
+
+        for (const auto &n : ::multiPassSelectNs)
+        {
+            b->Arg(n);
+        }
+        b->UseRealTime();
+    }
+
+    for (const auto inputData : { InputData::SortedArray,
+                                  InputData::ReversedSortedArray,
+                                  InputData::RandomArray })
+    {
+        const auto name =
+            (std::stringstream{} << "kthOrderStatistics/RadixSelect/" << inputData)
+                .str();
+
+        auto b = benchmark::RegisterBenchmark(name, BM_radixSelect, inputData);
+
+        for (const auto &n : ::radixSelectNs)
+        {
+            b->Arg(n);
+        }
+    }
+
+    for (const auto inputData : { InputData::SortedArray,
+                                  InputData::ReversedSortedArray,
+                                  InputData::RandomArray })
+    {
+        const auto name = (std::stringstream{}
+                           << "kthOrderStatistics/ParallelQuickSelect/" << inputData)
+                              .str();
+
+        auto b = benchmark::RegisterBenchmark(
+            name, BM_parallelQuickSelect, inputData);
+
+        for (const auto &n : ::parallelQuickSelectNs)
+        {
+            for (const auto &threads : ::parallelQuickSelectThreads)
+                b->Args({ n, threads });
+        }
+        b->UseRealTime();
+    }
+
+    for (const auto pivotPolicy :
+         { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+    {
+        for (const auto inputData : { InputData::SortedArray,
+                                      InputData::ReversedSortedArray,
+                                      InputData::RandomArray })
+        {
+            const auto key = std::make_pair(
+                static_cast<::PivotPolicy>(pivotPolicy),
+                static_cast<::InputData>(inputData));
+
+            const auto it = data.find(key);
+            if (it == data.end())
+                continue;
+
+            for (const auto perRank : { false, true })
+            {
+                const auto name =
+                    (std::stringstream{}
+                     << "multiSelect/" << pivotPolicy << "Pivot/" << inputData
+                     << (perRank ? "/QuickSelectPerRank" : ""))
+                        .str();
+
+                auto b = benchmark::RegisterBenchmark(
+                    name, BM_multiSelect, pivotPolicy, inputData, perRank);
+
+                for (const auto &n : it->second)
+                {
+                    for (const auto &r : ::multiSelectRanks)
+                        b->Args({ n, r });
+                }
+            }
+        }
+    }
+
+    for (const auto quantiles : { false, true })
+    {
+        auto b = benchmark::RegisterBenchmark(
+            quantiles ? "kllSketch/UpdateAndQuery" : "kllSketch/Update",
+            BM_kllSketchUpdate,
+            quantiles);
+
+        for (const auto &n : ::kllSketchNs)
+        {
+            for (const auto &k : ::kllSketchKs)
+                b->Args({ n, k });
+        }
+    }
+
+    {
+        auto b = benchmark::RegisterBenchmark("kllSketch/Merge", BM_kllSketchMerge);
+
+        for (const auto &count : ::kllSketchMerged)
+        {
+            for (const auto &k : ::kllSketchKs)
+                b->Args({ count, k });
+        }
+    }
+
+    {
+        auto b =
+            benchmark::RegisterBenchmark("kllSketch/Parallel", BM_kllSketchParallel);
+
+        for (const auto &n : ::kllSketchNs)
+        {
+            for (const auto &threads : ::parallelQuickSelectThreads)
+                b->Args({ n, threads });
+        }
+        b->UseRealTime();
+    }
+
+    const std::pair<DynamicKthMethod, const char *> dynamicKthMethods[] = {
+        { DynamicKthMethod::BTree, "dynamicKth/BTree" },
+        { DynamicKthMethod::Fenwick, "dynamicKth/Fenwick" },
+        { DynamicKthMethod::QuickSelect, "dynamicKth/QuickSelect" },
+    };
+
+    for (const auto &[method, name] : dynamicKthMethods)
+    {
+        auto b = benchmark::RegisterBenchmark(name, BM_dynamicKth, method);
+
+        for (const auto &n : ::dynamicKthNs)
+        {
+            // O(n) per query is too slow beyond that
+            if (method == DynamicKthMethod::QuickSelect && n > 100000)
+                continue;
+            for (const auto &queryPercent : ::dynamicKthQueryPercents)
+                b->Args({ n, queryPercent });
+        }
+        b->ArgNames({ "n", "queryPercent" });
+    }
+
+    for (const auto smallDomain : { false, true })
+    {
+        auto b = benchmark::RegisterBenchmark(
+            smallDomain ? "waveletMatrix/Build/SmallDomain" : "waveletMatrix/Build",
+            BM_waveletMatrixBuild,
+            smallDomain);
+
+        for (const auto &n : ::waveletMatrixNs)
+            b->Arg(n);
+    }
+
+    const std::pair<RangeQuery, const char *> rangeQueries[] = {
+        { RangeQuery::Kth, "Kth" },
+        { RangeQuery::Count, "Count" },
+        { RangeQuery::Median, "Median" },
+    };
+
+    for (const auto &[query, queryName] : rangeQueries)
+    {
+        for (const auto copyAndSelect : { false, true })
+        {
+            const auto name = (std::stringstream{} << "waveletMatrix/Range" << queryName
+                                                   << (copyAndSelect ? "/CopyAndSelect" : ""))
+                                  .str();
+
+            auto b = benchmark::RegisterBenchmark(name, BM_rangeQuery, query, copyAndSelect);
+
+            for (const auto &n : ::waveletMatrixNs)
+            {
+                // queries do not depend much on n beyond that, the build does
+                if (n > 1000000)
+                    continue;
+                for (const auto &length : ::waveletMatrixRangeLengths)
+                {
+                    // O(length) per query is too slow beyond that
+                    if (length <= n && (!copyAndSelect || length <= 10000))
+                        b->Args({ n, length });
+                }
+            }
+            b->ArgNames({ "n", "length" });
+        }
+    }
+}
+
+const int kTmp{ []() -> int
+                {
+                    registerBenchmarks();
+                    return 0;
+                }() };
+
+class KthOrderStatistics
+    : public ::testing::TestWithParam<std::tuple<PivotPolicy, Test>>
+{
+protected:
+    void SetUp() override
+    {
+        const auto &[testPivotPolicy, test] = GetParam();
+
+        auto shouldBeSkipped = true;
+
+        for (const auto &[key, val] : ::benchmarksData.getData())
+        {
+            const auto &[pivotPolicy, inputData] = key;
+
+            if (pivotPolicy == testPivotPolicy)
+                shouldBeSkipped = false;
+        }
+
+        if (shouldBeSkipped)
+        {
+            GTEST_SKIP();
+        }
+    }
+};
+
+TEST_P(KthOrderStatistics, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    QuickSelect_f quickSelect = getQuickSelectF(pivotPolicy);
+    Pivot_f       pivot       = getPivotF(pivotPolicy);
+    auto          values      = test.values;
+    auto          k           = test.k;
+
+    const auto actual = quickSelect(values, k, pivot);
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: PivotPolicy=" << pivotPolicy << ", "
+        << "k = " << test.k << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    KthOrderStatistics,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    KthOrderStatistics,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    IntroselectPivot,
+    KthOrderStatistics,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Introselect }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    FloydRivestPivot,
+    KthOrderStatistics,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::FloydRivest }),
+        ::testing::ValuesIn(getTests())));
+
+class QuickSelectConst : public KthOrderStatistics
+{
+};
+
+TEST_P(QuickSelectConst, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    // shared between the tests, so that the scratch reuse is exercised as well
+    static auto scratch = std::vector<int>{};
+
+    Pivot_f    pivot  = getPivotF(pivotPolicy);
+    const auto values = test.values;
+
+    const auto actual = ::quickSelectConst(values, test.k, pivot, scratch);
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: quickSelectConst, PivotPolicy=" << pivotPolicy << ", "
+        << "k = " << test.k << ", v = " << toString(test.values);
+    ASSERT_EQ(values, test.values)
+        << "quickSelectConst modified its input, PivotPolicy=" << pivotPolicy;
+
+    ASSERT_EQ(::quickSelectConst(values, test.k, pivot), test.kthValue)
+        << "Wrong kth value: quickSelectConst with thread-local scratch, "
+        << "PivotPolicy=" << pivotPolicy << ", "
+        << "k = " << test.k << ", v = " << toString(test.values);
+}
+
+TEST_P(QuickSelectConst, PivotReorderingItsWindow)
+{
+    const auto &test = std::get<1>(GetParam());
+
+    // medianOfMediansPivot sorts groups of five of its window in place
+    auto       scratch = std::vector<int>{};
+    const auto values  = test.values;
+    const auto actual  = ::quickSelectConst(values, test.k, &::medianOfMediansPivot, scratch);
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: quickSelectConst with medianOfMediansPivot, "
+        << "k = " << test.k << ", v = " << toString(test.values);
+    ASSERT_EQ(values, test.values)
+        << "quickSelectConst with medianOfMediansPivot modified its input";
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    QuickSelectConst,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    QuickSelectConst,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getTests())));
+
+class AnytimeSelect
+    : public ::testing::TestWithParam<std::tuple<PivotPolicy, int, Test>>
+{
+};
+
+TEST_P(AnytimeSelect, Correctness)
+{
+    const auto &[pivotPolicy, budgetPercent, test] = GetParam();
+
+    Pivot_f    pivot  = getPivotF(pivotPolicy);
+    auto       values = test.values;
+    const auto n      = static_cast<int>(values.size());
+    const auto budget = budgetPercent < 0 ? std::numeric_limits<size_t>::max()
+                                          : static_cast<size_t>(n) * budgetPercent / 100;
+
+    const auto actual = ::quickSelectBudgeted(values, test.k, pivot, budget);
+
+    auto sorted = test.values;
+    std::sort(sorted.begin(), sorted.end());
+
+    ASSERT_TRUE(
+        1 <= actual.rankLow && actual.rankLow <= test.k && test.k <= actual.rankHigh &&
+        actual.rankHigh <= n)
+        << "Wrong rank range: quickSelectBudgeted, PivotPolicy=" << pivotPolicy
+        << ", budget = " << budgetPercent << "%, range = [" << actual.rankLow << ", "
+        << actual.rankHigh << "], k = " << test.k << ", v = " << toString(test.values);
+    ASSERT_TRUE(
+        sorted[actual.rankLow - 1] <= actual.value &&
+        actual.value <= sorted[actual.rankHigh - 1])
+        << "Value outside of its rank range: quickSelectBudgeted, PivotPolicy="
+        << pivotPolicy << ", budget = " << budgetPercent
+        << "%, k = " << test.k << ", v = " << toString(test.values);
+
+    if (budgetPercent < 0 || actual.exact())
+    {
+        ASSERT_TRUE(actual.exact())
+            << "Unlimited budget should give exact result, PivotPolicy=" << pivotPolicy;
+        ASSERT_EQ(actual.value, test.kthValue)
+            << "Wrong kth value: quickSelectBudgeted, PivotPolicy=" << pivotPolicy
+            << ", k = " << test.k << ", v = " << toString(test.values);
+    }
+
+    values = test.values;
+
+    const auto late = ::quickSelectDeadline(
+        values, test.k, pivot, std::chrono::steady_clock::now() + std::chrono::hours{ 1 });
+    ASSERT_TRUE(late.exact() && late.value == test.kthValue)
+        << "Wrong kth value: quickSelectDeadline, PivotPolicy=" << pivotPolicy
+        << ", k = " << test.k << ", v = " << toString(test.values);
+
+    // an expired deadline does not start any partition: the window is the whole array
+    values = test.values;
+
+    const auto expired = ::quickSelectDeadline(
+        values, test.k, pivot, std::chrono::steady_clock::now() - std::chrono::seconds{ 1 });
+    ASSERT_TRUE(expired.rankLow == (n == 1 ? test.k : 1) && expired.rankHigh == (n == 1 ? test.k : n))
+        << "Wrong rank range: quickSelectDeadline with an expired deadline, PivotPolicy="
+        << pivotPolicy << ", range = [" << expired.rankLow << ", " << expired.rankHigh
+        << "], k = " << test.k << ", v = " << toString(test.values);
+    ASSERT_TRUE(expired.value == test.values[test.k - 1] && values == test.values)
+        << "quickSelectDeadline with an expired deadline modified its input, PivotPolicy="
+        << pivotPolicy << ", k = " << test.k << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    AnytimeSelect,
+    ::testing::Combine(
         ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn({ 0, 100, 250, -1 }),
         ::testing::ValuesIn(getTests())));
 INSTANTIATE_TEST_SUITE_P(
     UniformRandomPivot,
-    KthOrderStatistics,
+    AnytimeSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn({ 0, 100, 250, -1 }),
+        ::testing::ValuesIn(getTests())));
+
+class PayloadSelect : public KthOrderStatistics
+{
+};
+
+TEST_P(PayloadSelect, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    Pivot_f    pivot = getPivotF(pivotPolicy);
+    const auto n     = static_cast<int>(test.values.size());
+    const auto k     = test.k;
+
+    auto keys    = test.values;
+    auto rowIds  = std::vector<int>{};
+    auto doubled = std::vector<long long>{};
+    for (int i = 0; i < n; ++i)
+    {
+        rowIds.push_back(i);
+        doubled.push_back(2LL * test.values[i]);
+    }
+
+    const auto actual = ::quickSelectWithPayloads(keys, k, pivot, rowIds, doubled);
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: quickSelectWithPayloads, PivotPolicy=" << pivotPolicy
+        << ", k = " << k << ", v = " << toString(test.values);
+
+    for (int i = 0; i < n; ++i)
+    {
+        ASSERT_TRUE(i < k ? keys[i] <= actual : keys[i] >= actual)
+            << "Rows are not partitioned around the kth key, PivotPolicy=" << pivotPolicy
+            << ", k = " << k << ", v = " << toString(test.values);
+        ASSERT_TRUE(
+            test.values[rowIds[i]] == keys[i] && doubled[i] == 2LL * keys[i])
+            << "Payload was not moved together with its key, PivotPolicy="
+            << pivotPolicy << ", k = " << k << ", v = " << toString(test.values);
+    }
+
+    const auto indices = ::argSelect(test.values, k, pivot);
+
+    ASSERT_EQ(indices.size(), k)
+        << "argSelect should return k indices, PivotPolicy=" << pivotPolicy;
+    ASSERT_EQ(test.values[indices.back()], test.kthValue)
+        << "Wrong kth value: argSelect, PivotPolicy=" << pivotPolicy
+        << ", k = " << k << ", v = " << toString(test.values);
+
+    auto seen = std::vector<bool>(n, false);
+    for (const auto index : indices)
+    {
+        ASSERT_TRUE(
+            index < static_cast<size_t>(n) && !seen[index] && test.values[index] <= test.kthValue)
+            << "Wrong index returned by argSelect, PivotPolicy=" << pivotPolicy
+            << ", k = " << k << ", v = " << toString(test.values);
+        seen[index] = true;
+    }
+}
+
+/**
+ * @brief pivot that reads its window: the middle one of the first, middle and
+ * last element
+ */
+size_t medianOfThreePivot(int *data, size_t n)
+{
+    const size_t a = 0;
+    const size_t b = n / 2;
+    const size_t c = n;
+    if ((data[a] <= data[b]) == (data[b] <= data[c]))
+        return b;
+    if ((data[b] <= data[a]) == (data[a] <= data[c]))
+        return a;
+    return c;
+}
+
+TEST_P(PayloadSelect, Rows)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    const auto n = static_cast<int>(test.values.size());
+    const auto k = test.k;
+
+    for (const auto pivot : { getPivotF(pivotPolicy), &medianOfThreePivot })
+    {
+        auto rows = std::vector<Row<2>>(n);
+        for (int i = 0; i < n; ++i)
+            rows[i] = { test.values[i], { i, ~test.values[i] } };
+
+        const auto actual = ::quickSelectRows1(rows, k, pivot);
+
+        ASSERT_EQ(actual, test.kthValue)
+            << "Wrong kth value: quickSelectRows1, PivotPolicy=" << pivotPolicy
+            << ", medianOfThreePivot = " << (pivot == &medianOfThreePivot)
+            << ", k = " << k << ", v = " << toString(test.values);
+
+        for (int i = 0; i < n; ++i)
+        {
+            ASSERT_TRUE(i < k ? rows[i].key <= actual : rows[i].key >= actual)
+                << "Rows are not partitioned around the kth key, PivotPolicy="
+                << pivotPolicy << ", k = " << k << ", v = " << toString(test.values);
+            ASSERT_TRUE(
+                test.values[rows[i].payload[0]] == rows[i].key &&
+                rows[i].payload[1] == ~rows[i].key)
+                << "Payload was not moved together with its key, PivotPolicy="
+                << pivotPolicy << ", k = " << k << ", v = " << toString(test.values);
+        }
+
+        const auto indices = ::argSelect(test.values, k, pivot);
+        ASSERT_EQ(test.values[indices.back()], test.kthValue)
+            << "Wrong kth value: argSelect, PivotPolicy=" << pivotPolicy
+            << ", medianOfThreePivot = " << (pivot == &medianOfThreePivot)
+            << ", k = " << k << ", v = " << toString(test.values);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    PayloadSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    PayloadSelect,
     ::testing::Combine(
         ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
         ::testing::ValuesIn(getTests())));
 
+class RadixSelect : public ::testing::TestWithParam<Test>
+{
+};
+
+TEST_P(RadixSelect, Correctness)
+{
+    const auto &test = GetParam();
+
+    auto values = test.values;
+    auto k      = test.k;
+
+    const auto actual = ::radixSelect(values, k);
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: radixSelect, "
+        << "k = " << test.k << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    RadixSelectTests,
+    RadixSelect,
+    ::testing::ValuesIn(getTests()));
+
+class ShardedSelect
+    : public ::testing::TestWithParam<std::tuple<int, bool, int, Test>>
+{
+};
+
+TEST_P(ShardedSelect, Correctness)
+{
+    const auto &[count, skewed, threads, test] = GetParam();
+
+    auto shards = splitIntoShards(test.values, count, skewed);
+
+    const auto actual = ::shardedSelect(shards, test.k, threads);
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: shardedSelect, shards = " << count
+        << ", skewed = " << skewed << ", threads = " << threads
+        << ", k = " << test.k << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ShardedSelectTests,
+    ShardedSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn({ 1, 3, 8 }),
+        ::testing::Bool(),
+        ::testing::ValuesIn({ 1, 3 }),
+        ::testing::ValuesIn(getTests())));
+
+class MultiPassSelect
+    : public ::testing::TestWithParam<std::tuple<size_t, bool, Test>>
+{
+};
+
+TEST_P(MultiPassSelect, Correctness)
+{
+    const auto &[memoryBudget, fromFile, test] = GetParam();
+
+    auto actual = 0;
+    if (fromFile)
+    {
+        const auto path = uniqueTempPath("multiPassSelect-test");
+        writeInt32File(path, test.values);
+
+        actual = ::multiPassSelect(Int32FileSource{ path, 7 }, test.k, memoryBudget);
+        std::filesystem::remove(path);
+    }
+    else
+    {
+        const auto source = SpanSource{ test.values.data(), test.values.size() };
+        actual            = ::multiPassSelect(source, test.k, memoryBudget);
+    }
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: multiPassSelect, memoryBudget = " << memoryBudget
+        << ", fromFile = " << fromFile << ", k = " << test.k
+        << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    MultiPassSelectTests,
+    MultiPassSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn(std::vector<size_t>{ 0, 2, 16 }),
+        ::testing::Values(false),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    MultiPassSelectFileTests,
+    MultiPassSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn(std::vector<size_t>{ 16 }),
+        ::testing::Values(true),
+        ::testing::ValuesIn(getTests())));
+
+class ParallelQuickSelect
+    : public ::testing::TestWithParam<std::tuple<int, Test>>
+{
+};
+
+TEST_P(ParallelQuickSelect, Correctness)
+{
+    const auto &[threads, test] = GetParam();
+
+    auto values = test.values;
+    auto k      = test.k;
+
+    // small cutoff, so that the parallel rounds run on the test arrays as well
+    const auto actual = ::parallelQuickSelect(values, k, threads, 47, 4);
+
+    ASSERT_EQ(actual, test.kthValue)
+        << "Wrong kth value: parallelQuickSelect, threads = " << threads << ", "
+        << "k = " << test.k << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ParallelQuickSelectTests,
+    ParallelQuickSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn({ 1, 2, 3, 4 }),
+        ::testing::ValuesIn(getTests())));
+
+TEST(ParallelQuickSelect, NonPositiveThreads)
+{
+    for (const int threads : { 0, -1 })
+    {
+        auto values = std::vector<int>{ 3, 1, 2 };
+        EXPECT_THROW(::parallelQuickSelect(values, 2, threads, 47, 4), std::runtime_error)
+            << "threads = " << threads;
+    }
+}
+
+class MultiSelect
+    : public ::testing::TestWithParam<std::tuple<PivotPolicy, MultiSelectTest>>
+{
+protected:
+    void SetUp() override
+    {
+        const auto &[testPivotPolicy, test] = GetParam();
+
+        auto shouldBeSkipped = true;
+
+        for (const auto &[key, val] : ::benchmarksData.getData())
+        {
+            const auto &[pivotPolicy, inputData] = key;
+
+            if (pivotPolicy == testPivotPolicy)
+                shouldBeSkipped = false;
+        }
+
+        if (shouldBeSkipped)
+        {
+            GTEST_SKIP();
+        }
+    }
+};
+
+TEST_P(MultiSelect, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    Pivot_f pivot  = getPivotF(pivotPolicy);
+    auto    values = test.values;
+
+    const auto actual = ::multiSelect(values, test.ks, pivot);
+
+    ASSERT_EQ(actual.size(), test.ks.size())
+        << "Wrong number of selected values: PivotPolicy=" << pivotPolicy;
+
+    for (size_t i = 0; i < test.ks.size(); ++i)
+    {
+        ASSERT_EQ(actual[i], test.kthValues[i])
+            << "Wrong kth value: PivotPolicy=" << pivotPolicy << ", "
+            << "ks = " << toString(test.ks) << ", i = " << i
+            << ", v = " << toString(test.values);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    MultiSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getMultiSelectTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    MultiSelect,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getMultiSelectTests())));
+
+class KllSketchAccuracy
+    : public ::testing::TestWithParam<std::tuple<InputData, size_t, size_t>>
+{
+};
+
+TEST_P(KllSketchAccuracy, Correctness)
+{
+    const auto &[inputData, k, threads] = GetParam();
+
+    auto gen = std::mt19937{ 47 };
+
+    for (const auto n : { 1, 50, 100000 })
+    {
+        const auto values = generateValues(gen, n, inputData);
+        const auto sketch = ::kllSketch(values, threads, k);
+
+        ASSERT_EQ(sketch.count(), n) << "KllSketch lost updates, n = " << n;
+        ASSERT_LE(sketch.retained(), 3 * k + 64)
+            << "KllSketch retains too many items, k = " << k << ", n = " << n;
+
+        // the answer has to lie between the exact quantiles 3 / k * n ranks
+        // below and above the requested one
+        const auto tolerance = static_cast<int>(3.0 / k * n);
+
+        for (const auto q : { 0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1.0 })
+        {
+            const auto rank = std::clamp(static_cast<int>(std::ceil(q * n)), 1, n);
+
+            auto       copy  = values;
+            const auto lower = ::quickSelect(copy, std::max(rank - tolerance, 1), uniformRandomPivot);
+            copy             = values;
+            const auto upper = ::quickSelect(copy, std::min(rank + tolerance, n), uniformRandomPivot);
+
+            const auto actual = sketch.quantile(q);
+            ASSERT_TRUE(lower <= actual && actual <= upper)
+                << "KllSketch quantile is too far from the exact one, q = " << q
+                << ", n = " << n << ", k = " << k << ", threads = " << threads
+                << ", inputData = " << inputData << ", actual = " << actual
+                << ", allowed = [" << lower << ", " << upper << "]";
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    KllSketchAccuracyTests,
+    KllSketchAccuracy,
+    ::testing::Combine(
+        ::testing::ValuesIn({ InputData::SortedArray,
+                              InputData::ReversedSortedArray,
+                              InputData::RandomArray }),
+        ::testing::ValuesIn(std::vector<size_t>{ 100, 200, 800 }),
+        ::testing::ValuesIn(std::vector<size_t>{ 1, 4 })));
+
+class DynamicKth : public ::testing::TestWithParam<std::tuple<int, int, int>>
+{
+};
+
+TEST_P(DynamicKth, Correctness)
+{
+    const auto &[n, queryPercent, domain] = GetParam();
+
+    auto gen    = std::mt19937{ 47 };
+    auto values = std::uniform_int_distribution<int>{ 0, domain - 1 };
+
+    auto initial = std::vector<int>{};
+    for (int i = 0; i < n; ++i)
+        initial.push_back(values(gen));
+
+    auto ops = generateOrderStatisticOps(gen, initial, 20000, queryPercent, domain);
+
+    // erases of missing values have to be ignored
+    ops.push_back({ OrderStatisticOp::Kind::Erase, -1 });
+    ops.push_back({ OrderStatisticOp::Kind::Erase, domain });
+
+    auto multiset = QuickSelectMultiset{ initial };
+    const auto expected = orderStatisticStream1(multiset, ops);
+
+    ASSERT_EQ(::dynamicKth(initial, ops), expected) << "dynamicKth: wrong answers, n = " << n << ", domain = " << domain;
+    ASSERT_EQ(::dynamicKthFenwick(initial, ops, -1, domain), expected)
+        << "dynamicKthFenwick: wrong answers, n = " << n << ", domain = " << domain;
+
+    // the same stream on both containers, ranks around every operation's
+    // value (or answer) against a sorted copy of the multiset
+    auto tree    = OrderStatisticTree{ initial };
+    auto fenwick = FenwickOrderStatistics{ -1, domain };
+    for (const auto value : initial)
+        fenwick.insert(value);
+
+    auto sorted = initial;
+    std::sort(sorted.begin(), sorted.end());
+
+    for (const auto &op : ops)
+    {
+        int probe = op.value;
+        switch (op.kind)
+        {
+        case OrderStatisticOp::Kind::Insert:
+            tree.insert(op.value);
+            fenwick.insert(op.value);
+            sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), op.value), op.value);
+            break;
+        case OrderStatisticOp::Kind::Erase:
+        {
+            tree.erase(op.value);
+            fenwick.erase(op.value);
+            const auto it = std::lower_bound(sorted.begin(), sorted.end(), op.value);
+            if (it != sorted.end() && *it == op.value)
+                sorted.erase(it);
+            break;
+        }
+        case OrderStatisticOp::Kind::Kth:
+            probe = sorted[op.value - 1];
+            break;
+        }
+
+        for (const auto value : { probe, probe + 1 })
+        {
+            const auto less = static_cast<size_t>(std::lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin());
+            ASSERT_EQ(tree.rank(value), less) << "OrderStatisticTree: wrong rank of " << value << ", n = " << n << ", domain = " << domain;
+            ASSERT_EQ(fenwick.rank(value), less)
+                << "FenwickOrderStatistics: wrong rank of " << value << ", n = " << n << ", domain = " << domain;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DynamicKthTests,
+    DynamicKth,
+    ::testing::Combine(
+        ::testing::ValuesIn({ 0, 1, 100, 5000 }),
+        ::testing::ValuesIn({ 0, 10, 50, 90 }),
+        ::testing::ValuesIn({ 3, 1000, 1000000 })));
+
+TEST(OrderStatisticTree, GrowAndShrink)
+{
+    // sequential inserts split only the rightmost nodes, erasing from both
+    // ends and the middle exercises the merges and the root collapse
+    auto tree      = OrderStatisticTree{};
+    auto reference = std::vector<int>{};
+    for (int i = 0; i < 50000; ++i)
+    {
+        tree.insert(i % 2 == 0 ? i : -i);
+        reference.push_back(i % 2 == 0 ? i : -i);
+    }
+    std::sort(reference.begin(), reference.end());
+
+    auto gen = std::mt19937{ 47 };
+    while (!reference.empty())
+    {
+        ASSERT_EQ(tree.size(), reference.size());
+
+        const auto at = reference.size() < 100
+                            ? std::uniform_int_distribution<size_t>{ 0, reference.size() - 1 }(gen)
+                            : (reference.size() % 3 == 0 ? 0 : reference.size() % 3 == 1 ? reference.size() - 1 : reference.size() / 2);
+        const auto value = reference[at];
+
+        ASSERT_EQ(tree.rank(value), static_cast<size_t>(std::lower_bound(reference.begin(), reference.end(), value) - reference.begin()));
+        ASSERT_EQ(tree.kth(at + 1), value);
+        ASSERT_TRUE(tree.erase(value));
+        ASSERT_FALSE(tree.erase(value)) << "OrderStatisticTree: erased a value twice";
+        reference.erase(reference.begin() + at);
+    }
+    ASSERT_EQ(tree.size(), 0);
+    ASSERT_EQ(tree.rank(0), 0);
+
+    tree.insert(7);
+    ASSERT_EQ(tree.kth(1), 7);
+}
+
+class WaveletMatrixQueries : public ::testing::TestWithParam<std::tuple<int, std::pair<int, int>>>
+{
+};
+
+TEST_P(WaveletMatrixQueries, Correctness)
+{
+    const auto &[n, domain] = GetParam();
+    const auto [lo, hi]     = domain;
+
+    auto gen   = std::mt19937{ 47 };
+    auto distr = std::uniform_int_distribution<int>{ lo, hi };
+
+    auto values = std::vector<int>{};
+    for (int i = 0; i < n; ++i)
+        values.push_back(distr(gen));
+
+    const auto index = ::waveletMatrix(values);
+    ASSERT_EQ(index.size(), values.size());
+
+    auto position = std::uniform_int_distribution<size_t>{ 0, values.size() - 1 };
+    for (int query = 0; query < 300; ++query)
+    {
+        auto l = position(gen);
+        auto r = position(gen);
+        if (l > r)
+            std::swap(l, r);
+
+        auto sorted = std::vector<int>(values.begin() + l, values.begin() + r + 1);
+        std::sort(sorted.begin(), sorted.end());
+
+        for (const auto k : { size_t{ 1 }, sorted.size(), std::uniform_int_distribution<size_t>{ 1, sorted.size() }(gen) })
+        {
+            ASSERT_EQ(index.rangeKth(l, r, k), sorted[k - 1])
+                << "rangeKth: l = " << l << ", r = " << r << ", k = " << k;
+        }
+
+        const auto expectedMedian =
+            (static_cast<long long>(sorted[(sorted.size() - 1) / 2]) + sorted[sorted.size() / 2]) / 2.0;
+        ASSERT_EQ(index.rangeMedian(l, r), expectedMedian) << "rangeMedian: l = " << l << ", r = " << r;
+
+        for (const auto &[a, b] : std::vector<std::pair<int, int>>{
+                 { distr(gen), distr(gen) },
+                 { values[l], values[r] },
+                 { std::numeric_limits<int>::min(), std::numeric_limits<int>::max() },
+                 { std::numeric_limits<int>::min(), values[l] },
+                 { values[r], std::numeric_limits<int>::max() } })
+        {
+            const auto countLo = std::min(a, b);
+            const auto countHi = std::max(a, b);
+            const auto expected =
+                std::upper_bound(sorted.begin(), sorted.end(), countHi) - std::lower_bound(sorted.begin(), sorted.end(), countLo);
+            ASSERT_EQ(index.rangeCount(l, r, countLo, countHi), static_cast<size_t>(expected))
+                << "rangeCount: l = " << l << ", r = " << r << ", [" << countLo << ", " << countHi << "]";
+        }
+        ASSERT_EQ(index.rangeCount(l, r, 1, 0), 0) << "rangeCount: empty value range";
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    WaveletMatrixTests,
+    WaveletMatrixQueries,
+    ::testing::Combine(
+        ::testing::ValuesIn({ 1, 2, 7, 100, 1000, 5000 }),
+        ::testing::ValuesIn(std::vector<std::pair<int, int>>{
+            { 5, 5 },
+            { -3, 3 },
+            { -1000, 1000 },
+            { std::numeric_limits<int>::min(), std::numeric_limits<int>::max() } })));
+
 }    // namespace Utils::KthOrderStatistics
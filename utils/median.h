@@ -1,8 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <limits>
+#include <map>
 #include <ostream>
 #include <random>
 #include <sstream>
@@ -20,6 +22,65 @@
 
 double medianDeterministicPivot(std::vector<int> &v);
 double medianUniformRandomPivot(std::vector<int> &v);
+double medianIntroselect(std::vector<int> &v);
+
+std::pair<int, int> medianPair(std::vector<int> &v, Pivot_f pivotFunction);
+
+double medianConst(const std::vector<int> &v, Pivot_f pivotFunction, std::vector<int> &scratch);
+double medianConst(const std::vector<int> &v, Pivot_f pivotFunction);
+
+template <typename Source>
+double multiPassMedian(const Source &source, size_t memoryBudget);
+
+double shardedMedian(std::vector<std::vector<int>> &shards, size_t threads);
+
+double weightedMedian(std::vector<int> &values, std::vector<long long> &weights, Pivot_f pivotFunction);
+int    weightedQuantile(
+       std::vector<int>       &values,
+       std::vector<long long> &weights,
+       double                  q,
+       Pivot_f                 pivotFunction);
+
+std::vector<double> runningMedians(const std::vector<int> &v);
+void slidingWindowMedian(const std::vector<int> &v, size_t window, std::vector<double> &medians);
+int  histogramMedian(const std::vector<int> &v);
+
+RobustStats robustStats(std::vector<int> &v, double trim, Pivot_f pivotFunction);
+
+void medianFilter(
+    const std::vector<int> &image,
+    size_t                  cols,
+    size_t                  radius,
+    size_t                  threads,
+    MedianFilterMethod      method,
+    std::vector<int>       &filtered);
+
+void groupedMedians(
+    std::vector<int> &values, const std::vector<size_t> &offsets, size_t threads, std::vector<double> &medians);
+void groupedQuantiles(
+    std::vector<int>          &values,
+    const std::vector<size_t> &offsets,
+    double                     q,
+    size_t                     threads,
+    std::vector<int>          &quantiles);
+void groupedMediansByKey(
+    std::vector<int>    &keys,
+    std::vector<int>    &values,
+    size_t               threads,
+    std::vector<int>    &groupKeys,
+    std::vector<double> &medians);
+
+extern const std::vector<long long> weightedMedianMaxWeights;
+extern const std::vector<long long> slidingWindowMedianNs;
+extern const std::vector<long long> slidingWindowMedianWindows;
+extern const std::vector<long long> hdrHistogramNs;
+extern const std::vector<long long> robustStatsTrimPercents;
+extern const std::vector<long long> medianFilterSides;
+extern const std::vector<long long> medianFilterRadii;
+extern const std::vector<long long> medianFilterThreads;
+extern const std::vector<long long> groupedMedianNs;
+extern const std::vector<long long> groupedMedianGroupSizes;
+extern const std::vector<long long> groupedMedianThreads;
 
 extern const BenchmarkData benchmarksData;
 
@@ -39,6 +100,14 @@ median_fn getMedianFn(PivotPolicy pivotPolicy)
     case PivotPolicy::UniformRandom:
         res = &::medianUniformRandomPivot;
         break;
+    case PivotPolicy::Introselect:
+        res = &::medianIntroselect;
+        break;
+    case PivotPolicy::MedianDeterministic:
+    case PivotPolicy::MedianUniformRandom:
+    case PivotPolicy::FloydRivest:
+        // no median function for these policies
+        break;
     }
 
     if (res == nullptr)
@@ -49,6 +118,29 @@ median_fn getMedianFn(PivotPolicy pivotPolicy)
     return res;
 }
 
+Pivot_f getPivotF(PivotPolicy pivotPolicy)
+{
+    switch (pivotPolicy)
+    {
+    case PivotPolicy::Deterministic:
+        return &::deterministicPivot;
+    case PivotPolicy::UniformRandom:
+        return &::uniformRandomPivot;
+    case PivotPolicy::Introselect:
+        // fast path of introselect, medianOfMediansPivot is used on stalls
+        return &::deterministicPivot;
+    case PivotPolicy::FloydRivest:
+        // finishes windows below kFloydRivestCutoff
+        return &::uniformRandomPivot;
+    case PivotPolicy::MedianDeterministic:
+    case PivotPolicy::MedianUniformRandom:
+        // quick sort policies
+        break;
+    }
+
+    throw InternalError{ "median.h: pivot function cannot be nullptr" };
+}
+
 struct Test
 {
     Test() = delete;
@@ -64,6 +156,9 @@ struct Test
             median = v[v.size() / 2];
         else
             median = (v[v.size() / 2] + v[v.size() / 2 - 1]) / 2.0;
+
+        lowerMedian = v[(v.size() - 1) / 2];
+        upperMedian = v[v.size() / 2];
     }
 
     Test(const Test &) = default;
@@ -76,6 +171,9 @@ struct Test
 
     std::vector<int> values;
     double           median;
+
+    int lowerMedian;
+    int upperMedian;
 };
 
 std::vector<Test> getTests()
@@ -123,6 +221,123 @@ std::vector<Test> getTests()
     return tests;
 }
 
+const std::vector<double> kWeightedQuantiles{ 0.0, 0.1, 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+struct WeightedTest
+{
+    WeightedTest() = delete;
+    WeightedTest(std::vector<int> v, std::vector<long long> w)
+    {
+        if (v.size() != w.size() || v.empty())
+            throw InternalError{ "WeightedTest: wrong sizes of values/weights" };
+
+        values  = v;
+        weights = w;
+
+        auto expanded = std::vector<int>{};
+        for (size_t i = 0; i < v.size(); ++i)
+            expanded.insert(expanded.end(), w[i], v[i]);
+
+        if (expanded.empty())
+            throw InternalError{ "WeightedTest: total weight should be positive" };
+
+        std::sort(expanded.begin(), expanded.end());
+
+        const auto total = static_cast<long long>(expanded.size());
+        if (total % 2 == 1)
+            median = expanded[total / 2];
+        else
+            median = (expanded[total / 2] + expanded[total / 2 - 1]) / 2.0;
+
+        for (const auto q : kWeightedQuantiles)
+        {
+            const auto rank =
+                std::clamp<long long>(static_cast<long long>(std::ceil(q * total)), 1, total);
+            quantiles.push_back(expanded[rank - 1]);
+        }
+    }
+
+    WeightedTest(const WeightedTest &) = default;
+    WeightedTest(WeightedTest &&)      = default;
+
+    WeightedTest &operator=(const WeightedTest &) = default;
+    WeightedTest &operator=(WeightedTest &&)      = default;
+
+    ~WeightedTest() = default;
+
+    std::vector<int>       values;
+    std::vector<long long> weights;
+
+    double           median;
+    std::vector<int> quantiles;
+};
+
+std::vector<WeightedTest> getWeightedTests()
+{
+    auto tests = std::vector<WeightedTest>{};
+
+    // every unweighted test with unit weights
+    for (const auto &test : getTests())
+        tests.emplace_back(test.values, std::vector<long long>(test.values.size(), 1));
+
+    tests.emplace_back(std::vector<int>{ 1, 2, 3 }, std::vector<long long>{ 1, 1, 5 });
+    tests.emplace_back(std::vector<int>{ 1, 2 }, std::vector<long long>{ 3, 3 });
+    tests.emplace_back(std::vector<int>{ 2, 1 }, std::vector<long long>{ 3, 3 });
+    tests.emplace_back(std::vector<int>{ 5, 1, 9 }, std::vector<long long>{ 0, 2, 2 });
+    tests.emplace_back(std::vector<int>{ 5, 1, 9, 7 }, std::vector<long long>{ 0, 0, 1, 0 });
+    tests.emplace_back(std::vector<int>{ 4, 4, 4 }, std::vector<long long>{ 1, 2, 3 });
+
+    auto gen = std::mt19937{ 47 };
+
+    for (int t = 1; t <= 20; ++t)
+    {
+        int n = t * 10;
+
+        auto valuesDistr  = std::uniform_int_distribution<int>{ -10, 10 };
+        auto weightsDistr = std::uniform_int_distribution<long long>{ 0, 5 };
+
+        auto values  = std::vector<int>{};
+        auto weights = std::vector<long long>{};
+
+        for (int i = 0; i < n; ++i)
+        {
+            values.push_back(valuesDistr(gen));
+            weights.push_back(weightsDistr(gen));
+        }
+        weights.back() += 1;
+
+        tests.emplace_back(values, weights);
+    }
+
+    return tests;
+}
+
+std::vector<int> generateValues(std::mt19937 &gen, int n, InputData inputData)
+{
+    auto valuesDistr = std::uniform_int_distribution<int>{ -1000, 1000 };
+
+    auto values = std::vector<int>{};
+    values.reserve(n);
+
+    for (int i = 0; i < n; ++i)
+        values.push_back(valuesDistr(gen));
+
+    switch (inputData)
+    {
+    case InputData::RandomArray:
+        break;
+    case InputData::SortedArray:
+        std::sort(values.begin(), values.end());
+        break;
+    case InputData::ReversedSortedArray:
+        std::sort(values.begin(), values.end());
+        std::reverse(values.begin(), values.end());
+        break;
+    }
+
+    return values;
+}
+
 static void
     BM_median(benchmark::State &state, PivotPolicy pivotPolicy, InputData inputData)
 {
@@ -132,129 +347,1718 @@ static void
     if (n <= 0)
         throw InternalError{ "BM_impl: n should be positive" };
 
-    auto valuesDistr = std::uniform_int_distribution<int>{ -1000, 1000 };
-
     median_fn medianFn = getMedianFn(pivotPolicy);
 
     for (auto _ : state)
     {
         state.PauseTiming();
 
-        auto values = std::vector<int>{};
-        values.reserve(n);
+        auto values = generateValues(gen, n, inputData);
 
-        for (int i = 0; i < n; ++i)
-            values.push_back(valuesDistr(gen));
+        state.ResumeTiming();
+
+        auto res = medianFn(values);
+        ::benchmark::DoNotOptimize(res);
+    }
+}
+
+/**
+ * @brief same as BM_median, but both middle elements are found with one
+ * medianPair call (compare with the median benchmarks on even n)
+ */
+static void BM_medianPair(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto values = generateValues(gen, n, inputData);
+
+        state.ResumeTiming();
+
+        auto res = ::medianPair(values, pivot);
+        ::benchmark::DoNotOptimize(res);
+    }
+}
+
+/**
+ * @brief medianConst on a fixed input with a thread-local scratch buffer, or
+ * (@p copyThenSelect) the usual copy of the input followed by medianPair
+ */
+static void BM_medianConst(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData,
+    bool              copyThenSelect)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    auto values = generateValues(gen, n, inputData);
 
-        switch (inputData)
+    for (auto _ : state)
+    {
+        if (copyThenSelect)
         {
-        case InputData::RandomArray:
-            break;
-        case InputData::SortedArray:
-            std::sort(values.begin(), values.end());
-            break;
-        case InputData::ReversedSortedArray:
-            std::sort(values.begin(), values.end());
-            std::reverse(values.begin(), values.end());
-            break;
+            auto copy = values;
+            auto res  = ::medianPair(copy, pivot);
+            ::benchmark::DoNotOptimize(res);
+        }
+        else
+        {
+            auto res = ::medianConst(values, pivot);
+            ::benchmark::DoNotOptimize(res);
         }
+    }
+}
+
+/**
+ * @brief weightedMedian of state.range(0) values with weights uniform in
+ * [1, state.range(1)], or (@p expandThenSelect) the median function of the same
+ * pivot policy on the array with every value repeated weight times
+ */
+static void BM_weightedMedian(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData,
+    bool              expandThenSelect)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n         = static_cast<int>(state.range(0));
+    const auto maxWeight = static_cast<long long>(state.range(1));
+    if (n <= 0 || maxWeight <= 0)
+        throw InternalError{ "BM_impl: n and max weight should be positive" };
+
+    auto weightsDistr = std::uniform_int_distribution<long long>{ 1, maxWeight };
+
+    median_fn medianFn = getMedianFn(pivotPolicy);
+    Pivot_f   pivot    = getPivotF(pivotPolicy);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto values  = generateValues(gen, n, inputData);
+        auto weights = std::vector<long long>{};
+        weights.reserve(n);
+
+        for (int i = 0; i < n; ++i)
+            weights.push_back(weightsDistr(gen));
 
         state.ResumeTiming();
 
-        auto res = medianFn(values);
-        ::benchmark::DoNotOptimize(res);
+        if (expandThenSelect)
+        {
+            auto expanded = std::vector<int>{};
+            for (int i = 0; i < n; ++i)
+                expanded.insert(expanded.end(), weights[i], values[i]);
+
+            auto res = medianFn(expanded);
+            ::benchmark::DoNotOptimize(res);
+        }
+        else
+        {
+            auto res = ::weightedMedian(values, weights, pivot);
+            ::benchmark::DoNotOptimize(res);
+        }
     }
 }
 
-void registerBenchmarks()
+/**
+ * @brief median after each of state.range(0) insertions: runningMedians, or
+ * (recompute = true) medianConst over the whole history after every insertion
+ */
+static void BM_runningMedian(benchmark::State &state, InputData inputData, bool recompute)
 {
-    const auto &data = ::benchmarksData.getData();
+    auto gen = std::mt19937{ 47 };
 
-    for (const auto pivotPolicy :
-         { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
+
+    auto scratch = std::vector<int>{};
+    auto history = std::vector<int>{};
+
+    for (auto _ : state)
     {
-        for (const auto inputData : { InputData::SortedArray,
-                                      InputData::ReversedSortedArray,
-                                      InputData::RandomArray })
+        state.PauseTiming();
+
+        auto values = generateValues(gen, n, inputData);
+
+        state.ResumeTiming();
+
+        if (recompute)
         {
-            const auto name = (std::stringstream{} << "median/" << pivotPolicy
-                                                   << "Pivot/" << inputData)
-                                  .str();
+            history.clear();
+            for (const auto value : values)
+            {
+                history.push_back(value);
+                auto res = ::medianConst(history, deterministicPivot, scratch);
+                ::benchmark::DoNotOptimize(res);
+            }
+        }
+        else
+        {
+            auto res = ::runningMedians(values);
+            ::benchmark::DoNotOptimize(res);
+        }
+    }
+}
 
-            const auto key = std::make_pair(
-                static_cast<::PivotPolicy>(pivotPolicy),
-                static_cast<::InputData>(inputData));
+/**
+ * @brief medians of all state.range(1) long windows of state.range(0) values:
+ * slidingWindowMedian, or (perWindow = true) medianConst on every window
+ */
+static void BM_slidingWindowMedian(benchmark::State &state, InputData inputData, bool perWindow)
+{
+    auto gen = std::mt19937{ 47 };
 
-            const auto it = data.find(key);
-            if (it == data.end())
-                continue;
+    const auto n      = static_cast<int>(state.range(0));
+    const auto window = static_cast<int>(state.range(1));
+    if (window <= 0 || window > n)
+        throw InternalError{ "BM_impl: window should be in [1, n]" };
 
-            auto b = benchmark::RegisterBenchmark(
-                name, BM_median, pivotPolicy, inputData);
+    auto scratch = std::vector<int>{};
+    auto slice   = std::vector<int>{};
+    auto medians = std::vector<double>{};
 
-            for (const auto &n : it->second)
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto values = generateValues(gen, n, inputData);
+
+        state.ResumeTiming();
+
+        if (perWindow)
+        {
+            medians.resize(n - window + 1);
+            for (int i = 0; i + window <= n; ++i)
             {
-                b->Arg(n);
+                slice.assign(values.begin() + i, values.begin() + i + window);
+                medians[i] = ::medianConst(slice, uniformRandomPivot, scratch);
             }
         }
+        else
+        {
+            ::slidingWindowMedian(values, window, medians);
+        }
+        ::benchmark::DoNotOptimize(medians.data());
     }
 }
 
-const int kTmp{ []() -> int
-                {
-                    registerBenchmarks();
-                    return 0;
-                }() };
+/**
+ * @brief latency-like samples (log-normal, median about 150) for the
+ * histogram benchmarks and tests
+ */
+std::vector<int> generateLatencies(std::mt19937 &gen, int n)
+{
+    auto distr = std::lognormal_distribution<double>{ 5.0, 1.0 };
 
-class Median : public ::testing::TestWithParam<std::tuple<PivotPolicy, Test>>
+    auto values = std::vector<int>{};
+    values.reserve(n);
+    for (int i = 0; i < n; ++i)
+        values.push_back(static_cast<int>(std::min(distr(gen), 1e9)));
+    return values;
+}
+
+/**
+ * @brief median of state.range(0) latency samples: recorded one by one into an
+ * HdrHistogram, or (storeThenMedian = true) appended to a vector and passed to
+ * medianDeterministicPivot
+ */
+static void BM_hdrHistogram(benchmark::State &state, bool storeThenMedian)
 {
-protected:
-    void SetUp() override
-    {
-        const auto &[testPivotPolicy, test] = GetParam();
+    auto gen = std::mt19937{ 47 };
 
-        auto shouldBeSkipped = true;
+    const auto n = static_cast<int>(state.range(0));
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
 
-        for (const auto &[key, val] : ::benchmarksData.getData())
+    const auto latencies = generateLatencies(gen, n);
+
+    auto samples = std::vector<int>{};
+
+    for (auto _ : state)
+    {
+        if (storeThenMedian)
         {
-            const auto &[pivotPolicy, inputData] = key;
+            samples.clear();
+            for (const auto latency : latencies)
+                samples.push_back(latency);
 
-            if (pivotPolicy == testPivotPolicy)
-                shouldBeSkipped = false;
+            auto res = ::medianDeterministicPivot(samples);
+            ::benchmark::DoNotOptimize(res);
         }
-
-        if (shouldBeSkipped)
+        else
         {
-            GTEST_SKIP();
+            auto histogram = HdrHistogram<>{};
+            for (const auto latency : latencies)
+                histogram.record(latency);
+
+            auto res = histogram.quantile(0.5);
+            ::benchmark::DoNotOptimize(res);
         }
     }
-};
 
-TEST_P(Median, Correctness)
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**
+ * @brief robustStats with trim = state.range(1) percents on state.range(0)
+ * values, or (naive = true) the same numbers composed from the existing
+ * functions: medianConst for the median and the MAD, quickSelect on copies for
+ * each quartile and trimming bound, then a pass for the trimmed and winsorized
+ * means that keeps duplicates of the bounds up to their ranks
+ */
+static void BM_robustStats(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData,
+    bool              naive)
 {
-    const auto &[pivotPolicy, test] = GetParam();
+    auto gen = std::mt19937{ 47 };
 
-    auto medianFn = getMedianFn(pivotPolicy);
+    const auto n    = static_cast<int>(state.range(0));
+    const auto trim = state.range(1) / 100.0;
+    if (n <= 0)
+        throw InternalError{ "BM_impl: n should be positive" };
 
-    auto       values = test.values;
-    const auto actual = medianFn(values);
+    Pivot_f pivot = getPivotF(pivotPolicy);
 
-    ASSERT_LE(std::abs(actual - test.median), 1e-8)
-        << "Wrong median: PivotPolicy=" << pivotPolicy
-        << "v = " << toString(test.values);
-}
+    auto scratch    = std::vector<int>{};
+    auto copy       = std::vector<int>{};
+    auto deviations = std::vector<int>{};
 
-INSTANTIATE_TEST_SUITE_P(
-    DeterministicPivot,
-    Median,
-    ::testing::Combine(
-        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto values = generateValues(gen, n, inputData);
+
+        state.ResumeTiming();
+
+        if (naive)
+        {
+            const auto median = ::medianConst(values, pivot, scratch);
+
+            deviations.resize(n);
+            for (int i = 0; i < n; ++i)
+                deviations[i] = static_cast<int>(std::abs(2.0 * values[i] - 2.0 * median));
+            const auto mad = ::medianConst(deviations, pivot, scratch) / 2.0;
+
+            const auto g          = std::min(static_cast<int>(trim * n), (n - 1) / 2);
+            auto       orderStats = std::vector<int>{};
+            for (const auto k : { static_cast<int>(std::ceil(n / 4.0)),
+                                  static_cast<int>(std::ceil(3 * n / 4.0)),
+                                  g + 1,
+                                  n - g })
+            {
+                copy = values;
+                orderStats.push_back(quickSelect1(copy, std::max(k, 1), pivot));
+            }
+            const auto iqr = static_cast<double>(orderStats[1]) - orderStats[0];
+
+            // ranks g + 1 .. n - g are kept: everything strictly between the
+            // bounds plus as many copies of each bound as those ranks hold
+            const int lowBound  = orderStats[2];
+            const int highBound = orderStats[3];
+            long long between   = 0;
+            int       atMostLow = 0;
+            int       belowHigh = 0;
+            for (const auto value : values)
+            {
+                if (value > lowBound && value < highBound)
+                    between += value;
+                atMostLow += value <= lowBound;
+                belowHigh += value < highBound;
+            }
+            const long long middle =
+                lowBound == highBound
+                    ? static_cast<long long>(n - 2 * g) * lowBound
+                    : between + static_cast<long long>(atMostLow - g) * lowBound +
+                          static_cast<long long>(n - g - belowHigh) * highBound;
+            const auto trimmedMean    = static_cast<double>(middle) / (n - 2 * g);
+            const auto winsorizedMean = (static_cast<double>(middle) +
+                                         static_cast<double>(g) * lowBound +
+                                         static_cast<double>(g) * highBound) /
+                                        n;
+
+            ::benchmark::DoNotOptimize(mad);
+            ::benchmark::DoNotOptimize(iqr);
+            ::benchmark::DoNotOptimize(trimmedMean);
+            ::benchmark::DoNotOptimize(winsorizedMean);
+            ::benchmark::DoNotOptimize(orderStats.data());
+        }
+        else
+        {
+            auto res = ::robustStats(values, trim, pivot);
+            ::benchmark::DoNotOptimize(res);
+        }
+    }
+}
+
+/**
+ * @brief side x side image with a diagonal gradient plus uniform noise, values
+ * clamped to [0, maxValue] (sensor-like: locally correlated, noisy)
+ */
+std::vector<int> generateImage(std::mt19937 &gen, int side, int maxValue)
+{
+    auto noise = std::uniform_int_distribution<int>{ -maxValue / 8, maxValue / 8 };
+
+    auto image = std::vector<int>{};
+    image.reserve(static_cast<size_t>(side) * side);
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            const long long gradient = static_cast<long long>(x + y) * maxValue / (2 * side);
+            image.push_back(std::clamp<int>(static_cast<int>(gradient) + noise(gen), 0, maxValue));
+        }
+    }
+    return image;
+}
+
+/**
+ * @brief median filter of radius state.range(1) on a state.range(0) square
+ * image of values in [0, maxValue] with state.range(2) threads, or (perWindow =
+ * true) medianDeterministicPivot on a copy of every window
+ */
+static void BM_medianFilter(benchmark::State &state, MedianFilterMethod method, int maxValue, bool perWindow)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto side    = static_cast<int>(state.range(0));
+    const auto radius  = static_cast<int>(state.range(1));
+    const auto threads = static_cast<size_t>(state.range(2));
+    if (side <= 0 || radius < 0)
+        throw InternalError{ "BM_impl: side should be positive and radius non-negative" };
+
+    const auto image = generateImage(gen, side, maxValue);
+
+    auto filtered = std::vector<int>{};
+    auto window   = std::vector<int>{};
+
+    for (auto _ : state)
+    {
+        if (perWindow)
+        {
+            filtered.resize(image.size());
+            for (int y = 0; y < side; ++y)
+            {
+                for (int x = 0; x < side; ++x)
+                {
+                    window.clear();
+                    for (int dy = -radius; dy <= radius; ++dy)
+                    {
+                        for (int dx = -radius; dx <= radius; ++dx)
+                        {
+                            const int yy = std::clamp(y + dy, 0, side - 1);
+                            const int xx = std::clamp(x + dx, 0, side - 1);
+                            window.push_back(image[yy * side + xx]);
+                        }
+                    }
+                    filtered[y * side + x] = static_cast<int>(::medianDeterministicPivot(window));
+                }
+            }
+        }
+        else
+        {
+            ::medianFilter(image, side, radius, threads, method, filtered);
+        }
+        ::benchmark::DoNotOptimize(filtered.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+enum class GroupSizes
+{
+    Equal,          // every group has the mean size
+    Geometric,      // many small groups, a few a couple of times the mean
+    HeavyTailed,    // Pareto: mostly tiny groups and some huge ones
+};
+
+std::ostream &operator<<(std::ostream &os, GroupSizes groupSizes)
+{
+    switch (groupSizes)
+    {
+    case GroupSizes::Equal:
+        return os << "Equal";
+    case GroupSizes::Geometric:
+        return os << "Geometric";
+    case GroupSizes::HeavyTailed:
+        return os << "HeavyTailed";
+    }
+    return os;
+}
+
+/**
+ * @brief offsets of groups with sizes drawn from @p groupSizes with mean
+ * about @p meanSize, covering exactly @p n rows
+ */
+std::vector<size_t> generateGroupOffsets(std::mt19937 &gen, size_t n, size_t meanSize, GroupSizes groupSizes)
+{
+    auto geometric = std::geometric_distribution<size_t>{ 1.0 / meanSize };
+    auto uniform   = std::uniform_real_distribution<double>{ 0.0, 1.0 };
+
+    auto offsets = std::vector<size_t>{ 0 };
+    while (offsets.back() < n)
+    {
+        size_t size = meanSize;
+        switch (groupSizes)
+        {
+        case GroupSizes::Equal:
+            break;
+        case GroupSizes::Geometric:
+            size = geometric(gen) + 1;
+            break;
+        case GroupSizes::HeavyTailed:
+            // alpha = 1.2, scaled for the given mean
+            size = static_cast<size_t>(meanSize / 6.0 / std::pow(1.0 - uniform(gen), 1.0 / 1.2)) + 1;
+            break;
+        }
+        offsets.push_back(std::min(offsets.back() + size, n));
+    }
+    return offsets;
+}
+
+enum class GroupedMethod
+{
+    Offsets,            // groupedMedians
+    ByKey,              // groupedMediansByKey on shuffled rows
+    PerGroupVectors,    // copy every group to its own vector, medianDeterministicPivot on each
+};
+
+/**
+ * @brief medians of all groups of state.range(0) rows with mean group size
+ * state.range(1) on state.range(2) threads
+ */
+static void BM_groupedMedians(benchmark::State &state, GroupSizes groupSizes, GroupedMethod method)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n        = static_cast<size_t>(state.range(0));
+    const auto meanSize = static_cast<size_t>(state.range(1));
+    const auto threads  = static_cast<size_t>(state.range(2));
+    if (n == 0 || meanSize == 0)
+        throw InternalError{ "BM_impl: n and mean group size should be positive" };
+
+    const auto offsets = generateGroupOffsets(gen, n, meanSize, groupSizes);
+
+    auto valuesDistr = std::uniform_int_distribution<int>{ -1000000, 1000000 };
+
+    auto rowKeys = std::vector<int>(n);
+    for (size_t g = 0; g + 1 < offsets.size(); ++g)
+        std::fill(rowKeys.begin() + offsets[g], rowKeys.begin() + offsets[g + 1], static_cast<int>(g * 7919));
+    std::shuffle(rowKeys.begin(), rowKeys.end(), gen);
+
+    auto medians   = std::vector<double>{};
+    auto groupKeys = std::vector<int>{};
+    auto groups    = std::vector<std::vector<int>>{};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto values = std::vector<int>{};
+        values.reserve(n);
+
+        for (size_t i = 0; i < n; ++i)
+            values.push_back(valuesDistr(gen));
+
+        auto keys = rowKeys;
+
+        state.ResumeTiming();
+
+        switch (method)
+        {
+        case GroupedMethod::Offsets:
+            ::groupedMedians(values, offsets, threads, medians);
+            break;
+        case GroupedMethod::ByKey:
+            ::groupedMediansByKey(keys, values, threads, groupKeys, medians);
+            break;
+        case GroupedMethod::PerGroupVectors:
+            groups.clear();
+            medians.clear();
+            for (size_t g = 0; g + 1 < offsets.size(); ++g)
+            {
+                groups.emplace_back(values.begin() + offsets[g], values.begin() + offsets[g + 1]);
+                medians.push_back(::medianDeterministicPivot(groups.back()));
+            }
+            break;
+        }
+        ::benchmark::DoNotOptimize(medians.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+void registerBenchmarks()
+{
+    const auto &data = ::benchmarksData.getData();
+
+    for (const auto pivotPolicy : { PivotPolicy::Deterministic,
+                                    PivotPolicy::UniformRandom,
+                                    PivotPolicy::Introselect })
+    {
+        for (const auto inputData : { InputData::SortedArray,
+                                      InputData::ReversedSortedArray,
+                                      InputData::RandomArray })
+        {
+            const auto name = (std::stringstream{} << "median/" << pivotPolicy
+                                                   << "Pivot/" << inputData)
+                                  .str();
+
+            const auto key = std::make_pair(
+                static_cast<::PivotPolicy>(pivotPolicy),
+                static_cast<::InputData>(inputData));
+
+            const auto it = data.find(key);
+            if (it == data.end())
+                continue;
+
+            auto b = benchmark::RegisterBenchmark(
+                name, BM_median, pivotPolicy, inputData);
+
+            for (const auto &n : it->second)
+            {
+                b->Arg(n);
+            }
+        }
+    }
+
+    for (const auto pivotPolicy :
+         { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+    {
+        for (const auto inputData : { InputData::SortedArray,
+                                      InputData::ReversedSortedArray,
+                                      InputData::RandomArray })
+        {
+            const auto name = (std::stringstream{} << "medianPair/" << pivotPolicy
+                                                   << "Pivot/" << inputData)
+                                  .str();
+
+            const auto key = std::make_pair(
+                static_cast<::PivotPolicy>(pivotPolicy),
+                static_cast<::InputData>(inputData));
+
+            const auto it = data.find(key);
+            if (it == data.end())
+                continue;
+
+            auto b = benchmark::RegisterBenchmark(
+                name, BM_medianPair, pivotPolicy, inputData);
+
+            for (const auto &n : it->second)
+            {
+                b->Arg(n);
+            }
+        }
+    }
+
+    for (const auto pivotPolicy :
+         { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+    {
+        for (const auto inputData : { InputData::SortedArray,
+                                      InputData::ReversedSortedArray,
+                                      InputData::RandomArray })
+        {
+            const auto key = std::make_pair(
+                static_cast<::PivotPolicy>(pivotPolicy),
+                static_cast<::InputData>(inputData));
+
+            const auto it = data.find(key);
+            if (it == data.end())
+                continue;
+
+            for (const auto expandThenSelect : { false, true })
+            {
+                const auto name =
+                    (std::stringstream{}
+                     << "weightedMedian/" << pivotPolicy << "Pivot/" << inputData
+                     << (expandThenSelect ? "/ExpandThenSelect" : ""))
+                        .str();
+
+                auto b = benchmark::RegisterBenchmark(
+                    name, BM_weightedMedian, pivotPolicy, inputData, expandThenSelect);
+
+                for (const auto &n : it->second)
+                {
+                    for (const auto &maxWeight : ::weightedMedianMaxWeights)
+                        b->Args({ n, maxWeight });
+                }
+            }
+
+            for (const auto copyThenSelect : { false, true })
+            {
+                const auto name =
+                    (std::stringstream{}
+                     << "medianConst/" << pivotPolicy << "Pivot/" << inputData
+                     << (copyThenSelect ? "/CopyThenSelect" : ""))
+                        .str();
+
+                auto b = benchmark::RegisterBenchmark(
+                    name, BM_medianConst, pivotPolicy, inputData, copyThenSelect);
+
+                for (const auto &n : it->second)
+                {
+                    b->Arg(n);
+                }
+            }
+        }
+    }
+
+    for (const auto inputData : { InputData::SortedArray,
+                                  InputData::ReversedSortedArray,
+                                  InputData::RandomArray })
+    {
+        const auto key = std::make_pair(PivotPolicy::Deterministic, inputData);
+
+        const auto it = data.find(key);
+        if (it == data.end())
+            continue;
+
+        for (const auto recompute : { false, true })
+        {
+            const auto name = (std::stringstream{} << "runningMedian/" << inputData
+                                                   << (recompute ? "/Recompute" : ""))
+                                  .str();
+
+            auto b = benchmark::RegisterBenchmark(
+                name, BM_runningMedian, inputData, recompute);
+
+            for (const auto &n : it->second)
+            {
+                b->Arg(n);
+            }
+        }
+
+        for (const auto perWindow : { false, true })
+        {
+            const auto name =
+                (std::stringstream{} << "slidingWindowMedian/" << inputData
+                                     << (perWindow ? "/PerWindow" : ""))
+                    .str();
+
+            auto b = benchmark::RegisterBenchmark(
+                name, BM_slidingWindowMedian, inputData, perWindow);
+
+            for (const auto &n : ::slidingWindowMedianNs)
+            {
+                for (const auto &window : ::slidingWindowMedianWindows)
+                {
+                    // O(n * window) per iteration is too slow for long windows
+                    if (window <= n && (!perWindow || window <= 1000))
+                        b->Args({ n, window });
+                }
+            }
+        }
+    }
+
+    for (const auto storeThenMedian : { false, true })
+    {
+        auto b = benchmark::RegisterBenchmark(
+            storeThenMedian ? "hdrHistogram/StoreThenMedian" : "hdrHistogram/Record",
+            BM_hdrHistogram,
+            storeThenMedian);
+
+        for (const auto &n : ::hdrHistogramNs)
+        {
+            b->Arg(n);
+        }
+    }
+
+    for (const auto pivotPolicy :
+         { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+    {
+        for (const auto inputData : { InputData::SortedArray,
+                                      InputData::ReversedSortedArray,
+                                      InputData::RandomArray })
+        {
+            const auto key = std::make_pair(
+                static_cast<::PivotPolicy>(pivotPolicy),
+                static_cast<::InputData>(inputData));
+
+            const auto it = data.find(key);
+            if (it == data.end())
+                continue;
+
+            for (const auto naive : { false, true })
+            {
+                const auto name = (std::stringstream{}
+                                   << "robustStats/" << pivotPolicy << "Pivot/"
+                                   << inputData << (naive ? "/Naive" : ""))
+                                      .str();
+
+                auto b = benchmark::RegisterBenchmark(
+                    name, BM_robustStats, pivotPolicy, inputData, naive);
+
+                for (const auto &n : it->second)
+                {
+                    for (const auto &trimPercent : ::robustStatsTrimPercents)
+                        b->Args({ n, trimPercent });
+                }
+            }
+        }
+    }
+
+    for (const auto maxValue : { 255, 4095 })
+    {
+        const std::pair<MedianFilterMethod, const char *> methods[] = {
+            { MedianFilterMethod::Auto, "Auto" },
+            { MedianFilterMethod::Network, "Network" },
+            { MedianFilterMethod::Huang, "Huang" },
+            { MedianFilterMethod::ColumnHistogram, "ColumnHistogram" },
+        };
+
+        for (const auto &[method, methodName] : methods)
+        {
+            if (method == MedianFilterMethod::ColumnHistogram && maxValue > 255)
+                continue;
+
+            const auto name = (std::stringstream{} << "medianFilter/" << (maxValue == 255 ? "8bit/" : "12bit/")
+                                                   << methodName)
+                                  .str();
+
+            auto b = benchmark::RegisterBenchmark(name, BM_medianFilter, method, maxValue, false);
+
+            for (const auto &side : ::medianFilterSides)
+            {
+                for (const auto &radius : ::medianFilterRadii)
+                {
+                    if (method == MedianFilterMethod::Network && radius != 1 && radius != 2)
+                        continue;
+                    for (const auto &threads : ::medianFilterThreads)
+                        b->Args({ side, radius, threads });
+                }
+            }
+            b->ArgNames({ "side", "radius", "threads" })->UseRealTime();
+        }
+
+        auto b = benchmark::RegisterBenchmark(
+            maxValue == 255 ? "medianFilter/8bit/PerWindow" : "medianFilter/12bit/PerWindow",
+            BM_medianFilter,
+            MedianFilterMethod::Auto,
+            maxValue,
+            true);
+
+        for (const auto &side : ::medianFilterSides)
+        {
+            for (const auto &radius : ::medianFilterRadii)
+            {
+                // O(side^2 * radius^2) per iteration is too slow beyond that
+                if (side <= 256 && radius <= 4)
+                    b->Args({ side, radius, 1 });
+            }
+        }
+        b->ArgNames({ "side", "radius", "threads" });
+    }
+
+    for (const auto groupSizes : { GroupSizes::Equal, GroupSizes::Geometric, GroupSizes::HeavyTailed })
+    {
+        const std::pair<GroupedMethod, const char *> methods[] = {
+            { GroupedMethod::Offsets, "" },
+            { GroupedMethod::ByKey, "/ByKey" },
+            { GroupedMethod::PerGroupVectors, "/PerGroupVectors" },
+        };
+
+        for (const auto &[method, suffix] : methods)
+        {
+            const auto name =
+                (std::stringstream{} << "groupedMedians/" << groupSizes << suffix).str();
+
+            auto b = benchmark::RegisterBenchmark(name, BM_groupedMedians, groupSizes, method);
+
+            for (const auto &n : ::groupedMedianNs)
+            {
+                for (const auto &meanSize : ::groupedMedianGroupSizes)
+                {
+                    // the per-group baseline is single-threaded
+                    for (const auto &threads : ::groupedMedianThreads)
+                    {
+                        if (method != GroupedMethod::PerGroupVectors || threads == 1)
+                            b->Args({ n, meanSize, threads });
+                    }
+                }
+            }
+            b->ArgNames({ "n", "meanSize", "threads" })->UseRealTime();
+        }
+    }
+}
+
+const int kTmp{ []() -> int
+                {
+                    registerBenchmarks();
+                    return 0;
+                }() };
+
+class Median : public ::testing::TestWithParam<std::tuple<PivotPolicy, Test>>
+{
+protected:
+    void SetUp() override
+    {
+        const auto &[testPivotPolicy, test] = GetParam();
+
+        auto shouldBeSkipped = true;
+
+        for (const auto &[key, val] : ::benchmarksData.getData())
+        {
+            const auto &[pivotPolicy, inputData] = key;
+
+            if (pivotPolicy == testPivotPolicy)
+                shouldBeSkipped = false;
+        }
+
+        if (shouldBeSkipped)
+        {
+            GTEST_SKIP();
+        }
+    }
+};
+
+TEST_P(Median, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    auto medianFn = getMedianFn(pivotPolicy);
+
+    auto       values = test.values;
+    const auto actual = medianFn(values);
+
+    ASSERT_LE(std::abs(actual - test.median), 1e-8)
+        << "Wrong median: PivotPolicy=" << pivotPolicy
+        << "v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    Median,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    Median,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    IntroselectPivot,
+    Median,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Introselect }),
+        ::testing::ValuesIn(getTests())));
+
+class MedianPair : public ::testing::TestWithParam<std::tuple<PivotPolicy, Test>>
+{
+protected:
+    void SetUp() override
+    {
+        const auto &[testPivotPolicy, test] = GetParam();
+
+        auto shouldBeSkipped = true;
+
+        for (const auto &[key, val] : ::benchmarksData.getData())
+        {
+            const auto &[pivotPolicy, inputData] = key;
+
+            if (pivotPolicy == testPivotPolicy)
+                shouldBeSkipped = false;
+        }
+
+        if (shouldBeSkipped)
+        {
+            GTEST_SKIP();
+        }
+    }
+};
+
+TEST_P(MedianPair, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    auto       values = test.values;
+    const auto actual = ::medianPair(values, pivot);
+
+    ASSERT_EQ(actual.first, test.lowerMedian)
+        << "Wrong lower median: PivotPolicy=" << pivotPolicy
+        << ", v = " << toString(test.values);
+    ASSERT_EQ(actual.second, test.upperMedian)
+        << "Wrong upper median: PivotPolicy=" << pivotPolicy
+        << ", v = " << toString(test.values);
+    ASSERT_LE(std::abs((actual.first + actual.second) / 2.0 - test.median), 1e-8)
+        << "Wrong median: PivotPolicy=" << pivotPolicy
+        << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    MedianPair,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    MedianPair,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getTests())));
+
+class MedianConst : public Median
+{
+};
+
+TEST_P(MedianConst, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    // shared between the tests, so that the scratch reuse is exercised as well
+    static auto scratch = std::vector<int>{};
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    const auto values = test.values;
+    const auto actual = ::medianConst(values, pivot, scratch);
+
+    ASSERT_LE(std::abs(actual - test.median), 1e-8)
+        << "Wrong median: medianConst, PivotPolicy=" << pivotPolicy
+        << ", v = " << toString(test.values);
+    ASSERT_EQ(values, test.values)
+        << "medianConst modified its input, PivotPolicy=" << pivotPolicy;
+
+    ASSERT_LE(std::abs(::medianConst(values, pivot) - test.median), 1e-8)
+        << "Wrong median: medianConst with thread-local scratch, PivotPolicy="
+        << pivotPolicy << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    MedianConst,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    MedianConst,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getTests())));
+
+class MultiPassMedian : public ::testing::TestWithParam<std::tuple<size_t, Test>>
+{
+};
+
+TEST_P(MultiPassMedian, Correctness)
+{
+    const auto &[memoryBudget, test] = GetParam();
+
+    const auto source = SpanSource{ test.values.data(), test.values.size() };
+    const auto actual = ::multiPassMedian(source, memoryBudget);
+
+    ASSERT_LE(std::abs(actual - test.median), 1e-8)
+        << "Wrong median: multiPassMedian, memoryBudget = " << memoryBudget
+        << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    MultiPassMedianTests,
+    MultiPassMedian,
+    ::testing::Combine(
+        ::testing::ValuesIn(std::vector<size_t>{ 0, 2, 16 }),
+        ::testing::ValuesIn(getTests())));
+
+class ShardedMedian : public ::testing::TestWithParam<std::tuple<int, Test>>
+{
+};
+
+TEST_P(ShardedMedian, Correctness)
+{
+    const auto &[count, test] = GetParam();
+
+    // round-robin split, some shards stay empty for short inputs
+    auto shards = std::vector<std::vector<int>>(count);
+    for (size_t i = 0; i < test.values.size(); ++i)
+        shards[i % count].push_back(test.values[i]);
+
+    const auto actual = ::shardedMedian(shards, 2);
+
+    ASSERT_LE(std::abs(actual - test.median), 1e-8)
+        << "Wrong median: shardedMedian, shards = " << count
+        << ", v = " << toString(test.values);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ShardedMedianTests,
+    ShardedMedian,
+    ::testing::Combine(
+        ::testing::ValuesIn({ 1, 2, 5 }),
         ::testing::ValuesIn(getTests())));
+
+class WeightedMedian
+    : public ::testing::TestWithParam<std::tuple<PivotPolicy, WeightedTest>>
+{
+};
+
+TEST_P(WeightedMedian, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    auto       values  = test.values;
+    auto       weights = test.weights;
+    const auto actual  = ::weightedMedian(values, weights, pivot);
+
+    ASSERT_LE(std::abs(actual - test.median), 1e-8)
+        << "Wrong weighted median: PivotPolicy=" << pivotPolicy
+        << ", v = " << toString(test.values);
+
+    for (size_t i = 0; i < kWeightedQuantiles.size(); ++i)
+    {
+        values  = test.values;
+        weights = test.weights;
+
+        const auto q = kWeightedQuantiles[i];
+        ASSERT_EQ(::weightedQuantile(values, weights, q, pivot), test.quantiles[i])
+            << "Wrong weighted quantile: PivotPolicy=" << pivotPolicy
+            << ", q = " << q << ", v = " << toString(test.values);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    WeightedMedian,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getWeightedTests())));
 INSTANTIATE_TEST_SUITE_P(
     UniformRandomPivot,
-    Median,
+    WeightedMedian,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getWeightedTests())));
+
+class RunningMedian : public ::testing::TestWithParam<Test>
+{
+};
+
+TEST_P(RunningMedian, Correctness)
+{
+    const auto &test = GetParam();
+    const auto &v    = test.values;
+
+    const auto medians = ::runningMedians(v);
+    ASSERT_EQ(medians.size(), v.size());
+
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        const auto expected =
+            Utils::Median::Test{ std::vector<int>(v.begin(), v.begin() + i + 1) };
+        ASSERT_LE(std::abs(medians[i] - expected.median), 1e-8)
+            << "Wrong running median after " << i + 1
+            << " insertions, v = " << toString(v);
+    }
+
+    // bulk insertion: the first batch is merged into an empty object, the
+    // second (smaller) one is inserted value by value
+    auto median = ::RunningMedian{};
+    median.insert(std::vector<int>(v.begin(), v.begin() + (v.size() + 1) * 2 / 3));
+    median.insert(std::vector<int>(v.begin() + (v.size() + 1) * 2 / 3, v.end()));
+
+    ASSERT_EQ(median.size(), v.size());
+    ASSERT_EQ(median.lowerMedian(), test.lowerMedian)
+        << "Wrong lower median after bulk insertion, v = " << toString(v);
+    ASSERT_EQ(median.upperMedian(), test.upperMedian)
+        << "Wrong upper median after bulk insertion, v = " << toString(v);
+
+    // erase everything in a random order, checking the median of what is left
+    auto gen       = std::mt19937{ 47 };
+    auto remaining = v;
+    std::shuffle(remaining.begin(), remaining.end(), gen);
+    while (remaining.size() > 1)
+    {
+        median.erase(remaining.back());
+        remaining.pop_back();
+
+        const auto expected = Utils::Median::Test{ remaining };
+        ASSERT_EQ(median.size(), remaining.size());
+        ASSERT_EQ(median.lowerMedian(), expected.lowerMedian)
+            << "Wrong lower median after erase, left = " << toString(remaining)
+            << ", v = " << toString(v);
+        ASSERT_EQ(median.upperMedian(), expected.upperMedian)
+            << "Wrong upper median after erase, left = " << toString(remaining)
+            << ", v = " << toString(v);
+    }
+
+    // a batch as large as the contents rebuilds the heaps, stale entries of the
+    // erased values must not come back
+    median.insert(v);
+    remaining.insert(remaining.end(), v.begin(), v.end());
+
+    const auto expected = Utils::Median::Test{ remaining };
+    ASSERT_EQ(median.size(), remaining.size());
+    ASSERT_EQ(median.lowerMedian(), expected.lowerMedian)
+        << "Wrong lower median after erase and bulk insertion, v = " << toString(v);
+    ASSERT_EQ(median.upperMedian(), expected.upperMedian)
+        << "Wrong upper median after erase and bulk insertion, v = " << toString(v);
+}
+
+INSTANTIATE_TEST_SUITE_P(RunningMedianTests, RunningMedian, ::testing::ValuesIn(getTests()));
+
+class SlidingWindowMedian : public ::testing::TestWithParam<std::tuple<size_t, Test>>
+{
+};
+
+TEST_P(SlidingWindowMedian, Correctness)
+{
+    const auto &[maxWindow, test] = GetParam();
+
+    const auto window = std::min(maxWindow, test.values.size());
+
+    // sorted series leave erased values deep inside the heaps, which is what
+    // makes RunningMedian compact itself
+    auto sorted = test.values;
+    std::sort(sorted.begin(), sorted.end());
+
+    for (const auto &v : { test.values, sorted })
+    {
+        auto medians = std::vector<double>{};
+        ::slidingWindowMedian(v, window, medians);
+
+        ASSERT_EQ(medians.size(), v.size() - window + 1)
+            << "Wrong number of medians, window = " << window << ", v = " << toString(v);
+
+        for (size_t i = 0; i < medians.size(); ++i)
+        {
+            const auto expected = Utils::Median::Test{ std::vector<int>(
+                v.begin() + i, v.begin() + i + window) };
+            ASSERT_LE(std::abs(medians[i] - expected.median), 1e-8)
+                << "Wrong median of window " << i << ", window = " << window
+                << ", v = " << toString(v);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SlidingWindowMedianTests,
+    SlidingWindowMedian,
+    ::testing::Combine(
+        ::testing::ValuesIn(std::vector<size_t>{ 1, 2, 3, 8, 1000 }),
+        ::testing::ValuesIn(getTests())));
+
+class HistogramMedian : public ::testing::TestWithParam<Test>
+{
+};
+
+TEST_P(HistogramMedian, Correctness)
+{
+    const auto &test = GetParam();
+
+    // shifted to non-negative values below 128, which HdrHistogram<7> keeps exactly
+    const auto min     = *std::min_element(test.values.begin(), test.values.end());
+    auto       shifted = test.values;
+    for (auto &value : shifted)
+        value -= min;
+
+    ASSERT_EQ(::histogramMedian(shifted), test.lowerMedian - min)
+        << "Wrong histogram median, v = " << toString(shifted);
+}
+
+INSTANTIATE_TEST_SUITE_P(HistogramMedianTests, HistogramMedian, ::testing::ValuesIn(getTests()));
+
+TEST(HdrHistogram, Accuracy)
+{
+    auto gen = std::mt19937{ 47 };
+
+    auto uniform = std::vector<int>(100000);
+    auto distr   = std::uniform_int_distribution<int>{ 0, std::numeric_limits<int>::max() };
+    for (auto &value : uniform)
+        value = distr(gen);
+
+    for (const auto &values : { generateLatencies(gen, 100000), uniform })
+    {
+        auto parts = std::array<HdrHistogram<>, 4>{};
+        auto whole = HdrHistogram<>{};
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            whole.record(values[i]);
+            parts[i % parts.size()].record(values[i]);
+        }
+
+        auto merged = HdrHistogram<>{};
+        for (const auto &part : parts)
+            merged.merge(part);
+
+        ASSERT_EQ(merged.serialize(), whole.serialize())
+            << "Merged histogram differs from the one recorded directly";
+
+        const auto bytes    = whole.serialize();
+        const auto restored = HdrHistogram<>::deserialize(bytes);
+        ASSERT_EQ(restored.serialize(), bytes) << "Serialization round trip changed the histogram";
+        ASSERT_EQ(restored.count(), values.size());
+
+        auto sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+
+        for (const auto q : { 0.0, 0.01, 0.25, 0.5, 0.9, 0.99, 0.999, 1.0 })
+        {
+            const auto rank = std::clamp<size_t>(
+                static_cast<size_t>(std::ceil(q * sorted.size())), 1, sorted.size());
+            const double expected = sorted[rank - 1];
+            const double actual   = restored.quantile(q);
+
+            ASSERT_LE(std::abs(actual - expected), expected / 128.0)
+                << "HdrHistogram quantile is out of its error bound, q = " << q
+                << ", expected = " << expected << ", actual = " << actual;
+        }
+
+        auto truncated = bytes;
+        truncated.pop_back();
+        truncated.back() |= 0x80;
+        EXPECT_THROW(HdrHistogram<>::deserialize(truncated), std::runtime_error);
+        EXPECT_THROW(HdrHistogram<8>::deserialize(bytes), std::runtime_error);
+
+        auto trailing = bytes;
+        trailing.push_back(0);
+        EXPECT_THROW(HdrHistogram<>::deserialize(trailing), std::runtime_error);
+    }
+
+    EXPECT_THROW(HdrHistogram<>{}.record(-1), std::runtime_error);
+    EXPECT_THROW(HdrHistogram<>{}.record(std::numeric_limits<int>::min()), std::runtime_error);
+
+    // serialized form from raw varints
+    const auto encode = [](std::initializer_list<uint64_t> values)
+    {
+        auto bytes = std::vector<uint8_t>{};
+        for (auto x : values)
+        {
+            for (; x >= 0x80; x >>= 7)
+                bytes.push_back(static_cast<uint8_t>(x | 0x80));
+            bytes.push_back(static_cast<uint8_t>(x));
+        }
+        return bytes;
+    };
+    const uint64_t last = HdrHistogram<>::kBuckets - 1;
+    ASSERT_EQ(HdrHistogram<>::deserialize(encode({ 7, 2, 0, 1, 5, 1 })).count(), 2u);
+    ASSERT_EQ(HdrHistogram<>::deserialize(encode({ 7, 1, last, 3 })).count(), 3u);
+    ASSERT_EQ(HdrHistogram<>::deserialize(encode({ 7, 2, 5, 1, last - 5, 1 })).count(), 2u);
+    // repeated bucket index
+    EXPECT_THROW(HdrHistogram<>::deserialize({ 7, 2, 5, 1, 0, 1 }), std::runtime_error);
+    // index past the last bucket, directly and after a previous entry
+    EXPECT_THROW(HdrHistogram<>::deserialize(encode({ 7, 1, last + 1, 1 })), std::runtime_error);
+    EXPECT_THROW(HdrHistogram<>::deserialize(encode({ 7, 2, 5, 1, last - 4, 1 })),
+                 std::runtime_error);
+    // a gap that would wrap the index around
+    EXPECT_THROW(HdrHistogram<>::deserialize(encode({ 7, 2, 5, 1, ~uint64_t{ 0 } - 3, 1 })),
+                 std::runtime_error);
+    // empty bucket listed as used
+    EXPECT_THROW(HdrHistogram<>::deserialize({ 7, 1, 5, 0 }), std::runtime_error);
+}
+
+class RobustStats : public Median
+{
+};
+
+TEST_P(RobustStats, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    auto sorted = test.values;
+    std::sort(sorted.begin(), sorted.end());
+    const int n = sorted.size();
+
+    auto deviations = std::vector<double>{};
+    for (const auto value : sorted)
+        deviations.push_back(std::abs(value - test.median));
+    std::sort(deviations.begin(), deviations.end());
+    const auto mad = (deviations[(n - 1) / 2] + deviations[n / 2]) / 2.0;
+
+    for (const auto trim : { 0.0, 0.1, 0.25, 0.49 })
+    {
+        auto       values = test.values;
+        const auto actual = ::robustStats(values, trim, pivot);
+
+        const auto g = std::min(static_cast<int>(trim * n), (n - 1) / 2);
+
+        double trimmed    = 0;
+        double winsorized = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            if (i >= g && i < n - g)
+                trimmed += sorted[i];
+            winsorized += sorted[std::clamp(i, g, n - 1 - g)];
+        }
+        trimmed /= n - 2 * g;
+        winsorized /= n;
+
+        const auto message = [&]
+        {
+            return (std::stringstream{} << "PivotPolicy=" << pivotPolicy
+                                        << ", trim = " << trim
+                                        << ", v = " << toString(test.values))
+                .str();
+        };
+
+        ASSERT_LE(std::abs(actual.median - test.median), 1e-8)
+            << "Wrong median, " << message();
+        ASSERT_LE(std::abs(actual.mad - mad), 1e-8) << "Wrong MAD, " << message();
+        ASSERT_EQ(actual.lowerQuartile, sorted[std::max((n + 3) / 4, 1) - 1])
+            << "Wrong lower quartile, " << message();
+        ASSERT_EQ(actual.upperQuartile, sorted[std::max((3 * n + 3) / 4, 1) - 1])
+            << "Wrong upper quartile, " << message();
+        ASSERT_LE(
+            std::abs(
+                actual.interquartileRange -
+                (static_cast<double>(sorted[std::max((3 * n + 3) / 4, 1) - 1]) -
+                 sorted[std::max((n + 3) / 4, 1) - 1])),
+            1e-8)
+            << "Wrong interquartile range, " << message();
+        ASSERT_LE(std::abs(actual.trimmedMean - trimmed), 1e-8)
+            << "Wrong trimmed mean, " << message();
+        ASSERT_LE(std::abs(actual.winsorizedMean - winsorized), 1e-8)
+            << "Wrong winsorized mean, " << message();
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    RobustStats,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    RobustStats,
     ::testing::Combine(
         ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
         ::testing::ValuesIn(getTests())));
 
+TEST(RobustStats, IntExtremes)
+{
+    constexpr int kMin = std::numeric_limits<int>::min();
+    constexpr int kMax = std::numeric_limits<int>::max();
+
+    for (const auto &v : std::vector<std::vector<int>>{
+             { kMin, kMax },
+             { kMin, kMin, kMax },
+             { kMin, kMax, kMax, kMax },
+             { kMin, 0, kMax, 1, -1, kMin, kMax } })
+    {
+        auto sorted = v;
+        std::sort(sorted.begin(), sorted.end());
+        const int  n      = sorted.size();
+        const auto median = (static_cast<double>(sorted[(n - 1) / 2]) + sorted[n / 2]) / 2.0;
+
+        auto deviations = std::vector<double>{};
+        for (const auto value : sorted)
+            deviations.push_back(std::abs(value - median));
+        std::sort(deviations.begin(), deviations.end());
+        const auto mad = (deviations[(n - 1) / 2] + deviations[n / 2]) / 2.0;
+
+        for (const auto pivotPolicy : { PivotPolicy::Deterministic, PivotPolicy::UniformRandom })
+        {
+            auto       values = v;
+            const auto actual = ::robustStats(values, 0.0, getPivotF(pivotPolicy));
+            ASSERT_EQ(actual.median, median)
+                << "Wrong median, PivotPolicy=" << pivotPolicy << ", v = " << toString(v);
+            ASSERT_EQ(actual.mad, mad)
+                << "Wrong MAD, PivotPolicy=" << pivotPolicy << ", v = " << toString(v);
+        }
+    }
+}
+
+/**
+ * @brief brute-force median filter with edge replication, the reference for
+ * the MedianFilter tests
+ */
+std::vector<int> medianFilterReference(const std::vector<int> &image, int rows, int cols, int radius)
+{
+    auto res    = std::vector<int>(image.size());
+    auto window = std::vector<int>{};
+    for (int y = 0; y < rows; ++y)
+    {
+        for (int x = 0; x < cols; ++x)
+        {
+            window.clear();
+            for (int dy = -radius; dy <= radius; ++dy)
+            {
+                for (int dx = -radius; dx <= radius; ++dx)
+                    window.push_back(image[std::clamp(y + dy, 0, rows - 1) * cols + std::clamp(x + dx, 0, cols - 1)]);
+            }
+            std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+            res[y * cols + x] = window[window.size() / 2];
+        }
+    }
+    return res;
+}
+
+class MedianFilter : public ::testing::TestWithParam<std::tuple<MedianFilterMethod, int, std::pair<int, int>>>
+{
+};
+
+TEST_P(MedianFilter, Correctness)
+{
+    const auto &[method, radius, shape] = GetParam();
+    const auto [rows, cols]             = shape;
+
+    auto gen = std::mt19937{ 47 };
+
+    auto images = std::vector<std::vector<int>>{};
+    for (const auto &[lo, hi] : std::vector<std::pair<int, int>>{
+             { 0, 255 },
+             { -2, 2 },
+             { 0, 100000 },
+             { std::numeric_limits<int>::min(), std::numeric_limits<int>::max() } })
+    {
+        if (method == MedianFilterMethod::ColumnHistogram && static_cast<long long>(hi) - lo > 255)
+            continue;
+
+        auto distr = std::uniform_int_distribution<int>{ lo, hi };
+        auto image = std::vector<int>{};
+        for (int i = 0; i < rows * cols; ++i)
+            image.push_back(distr(gen));
+        images.push_back(image);
+    }
+
+    for (const auto &image : images)
+    {
+        const auto expected = medianFilterReference(image, rows, cols, radius);
+        for (const size_t threads : { 1, 3 })
+        {
+            auto filtered = std::vector<int>{};
+            ::medianFilter(image, cols, radius, threads, method, filtered);
+
+            ASSERT_EQ(filtered, expected) << "Wrong median filter, rows = " << rows << ", cols = " << cols
+                                          << ", radius = " << radius << ", threads = " << threads
+                                          << ", image = " << toString(image);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    MedianFilterTests,
+    MedianFilter,
+    ::testing::Combine(
+        ::testing::ValuesIn({ MedianFilterMethod::Auto,
+                              MedianFilterMethod::Huang,
+                              MedianFilterMethod::ColumnHistogram }),
+        ::testing::ValuesIn({ 0, 1, 2, 3, 7 }),
+        ::testing::ValuesIn(std::vector<std::pair<int, int>>{
+            { 1, 1 }, { 1, 20 }, { 20, 1 }, { 7, 13 }, { 33, 40 } })));
+// median networks are only built for radius 1 and 2
+INSTANTIATE_TEST_SUITE_P(
+    MedianFilterNetworkTests,
+    MedianFilter,
+    ::testing::Combine(
+        ::testing::Values(MedianFilterMethod::Network),
+        ::testing::ValuesIn({ 1, 2 }),
+        ::testing::ValuesIn(std::vector<std::pair<int, int>>{
+            { 1, 1 }, { 1, 20 }, { 20, 1 }, { 7, 13 }, { 33, 40 } })));
+
+TEST(MedianFilter, UnsupportedInputs)
+{
+    const auto image    = std::vector<int>(12 * 30, 7);
+    auto       filtered = std::vector<int>{};
+
+    for (const int radius : { 0, 3 })
+    {
+        EXPECT_THROW(
+            ::medianFilter(image, 30, radius, 1, MedianFilterMethod::Network, filtered),
+            std::runtime_error)
+            << "Network should reject radius " << radius;
+    }
+
+    // 257 distinct values
+    auto distinct = std::vector<int>(image.size());
+    for (size_t i = 0; i < distinct.size(); ++i)
+        distinct[i] = static_cast<int>(i % 257) * 1000;
+    EXPECT_THROW(
+        ::medianFilter(distinct, 30, 1, 1, MedianFilterMethod::ColumnHistogram, filtered),
+        std::runtime_error)
+        << "ColumnHistogram should reject more than 256 distinct values";
+}
+
+// median in long long, Test::median overflows for sums of large ints
+double referenceMedian(std::vector<int> v)
+{
+    std::sort(v.begin(), v.end());
+    return (static_cast<long long>(v[(v.size() - 1) / 2]) + v[v.size() / 2]) / 2.0;
+}
+
+class GroupedMedians
+    : public ::testing::TestWithParam<std::tuple<size_t, GroupSizes, size_t>>
+{
+};
+
+TEST_P(GroupedMedians, Correctness)
+{
+    const auto &[threads, groupSizes, meanSize] = GetParam();
+
+    auto gen = std::mt19937{ 47 };
+
+    for (const auto &[lo, hi] : std::vector<std::pair<int, int>>{
+             { -3, 3 },
+             { -1000, 1000 },
+             { std::numeric_limits<int>::min(), std::numeric_limits<int>::max() } })
+    {
+        auto distr = std::uniform_int_distribution<int>{ lo, hi };
+
+        const auto offsets = generateGroupOffsets(gen, 20000, meanSize, groupSizes);
+        auto       values  = std::vector<int>{};
+        for (size_t i = 0; i < offsets.back(); ++i)
+            values.push_back(distr(gen));
+
+        auto medians = std::vector<double>{};
+        auto grouped = values;
+        ::groupedMedians(grouped, offsets, threads, medians);
+
+        ASSERT_EQ(medians.size(), offsets.size() - 1);
+        for (size_t g = 0; g + 1 < offsets.size(); ++g)
+        {
+            const auto group = std::vector<int>(values.begin() + offsets[g], values.begin() + offsets[g + 1]);
+            ASSERT_EQ(medians[g], referenceMedian(group)) << "groupedMedians: wrong median of group " << g;
+
+            auto sortedGroup = group;
+            auto reordered   = std::vector<int>(grouped.begin() + offsets[g], grouped.begin() + offsets[g + 1]);
+            std::sort(sortedGroup.begin(), sortedGroup.end());
+            std::sort(reordered.begin(), reordered.end());
+            ASSERT_EQ(reordered, sortedGroup) << "groupedMedians: values moved between groups";
+        }
+
+        for (const double q : { 0.0, 0.25, 0.5, 0.9, 1.0 })
+        {
+            auto quantiles = std::vector<int>{};
+            auto copy      = values;
+            ::groupedQuantiles(copy, offsets, q, threads, quantiles);
+
+            for (size_t g = 0; g + 1 < offsets.size(); ++g)
+            {
+                auto group = std::vector<int>(values.begin() + offsets[g], values.begin() + offsets[g + 1]);
+                std::sort(group.begin(), group.end());
+                const auto rank = std::clamp<size_t>(static_cast<size_t>(std::ceil(q * group.size())), 1, group.size());
+                ASSERT_EQ(quantiles[g], group[rank - 1])
+                    << "groupedQuantiles: wrong quantile " << q << " of group " << g;
+            }
+        }
+
+        // the same groups under shuffled keys
+        auto keys = std::vector<int>(values.size());
+        for (size_t g = 0; g + 1 < offsets.size(); ++g)
+            std::fill(keys.begin() + offsets[g], keys.begin() + offsets[g + 1], static_cast<int>(g) * 37 - 5000);
+
+        auto expected = std::map<int, std::vector<int>>{};
+        for (size_t i = 0; i < keys.size(); ++i)
+            expected[keys[i]].push_back(values[i]);
+
+        auto rows = std::vector<size_t>(keys.size());
+        for (size_t i = 0; i < rows.size(); ++i)
+            rows[i] = i;
+        std::shuffle(rows.begin(), rows.end(), gen);
+        auto shuffledKeys   = std::vector<int>{};
+        auto shuffledValues = std::vector<int>{};
+        for (const auto i : rows)
+        {
+            shuffledKeys.push_back(keys[i]);
+            shuffledValues.push_back(values[i]);
+        }
+
+        auto groupKeys = std::vector<int>{};
+        ::groupedMediansByKey(shuffledKeys, shuffledValues, threads, groupKeys, medians);
+
+        ASSERT_EQ(groupKeys.size(), expected.size());
+        size_t g = 0;
+        for (const auto &[key, group] : expected)
+        {
+            ASSERT_EQ(groupKeys[g], key) << "groupedMediansByKey: wrong key order";
+            ASSERT_EQ(medians[g], referenceMedian(group))
+                << "groupedMediansByKey: wrong median of key " << key;
+            ++g;
+        }
+        ASSERT_TRUE(std::is_sorted(shuffledKeys.begin(), shuffledKeys.end()))
+            << "groupedMediansByKey: keys are not grouped";
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    GroupedMediansTests,
+    GroupedMedians,
+    ::testing::Combine(
+        ::testing::ValuesIn(std::vector<size_t>{ 1, 3 }),
+        ::testing::ValuesIn({ GroupSizes::Equal, GroupSizes::Geometric, GroupSizes::HeavyTailed }),
+        ::testing::ValuesIn(std::vector<size_t>{ 1, 2, 10, 100, 5000 })));
+
+// groups large enough to be selected in by several threads, between small ones
+TEST(GroupedMedians, LargeGroups)
+{
+    auto gen = std::mt19937{ 47 };
+
+    for (const auto &[lo, hi] : std::vector<std::pair<int, int>>{ { -3, 3 }, { -1000000, 1000000 } })
+    {
+        auto distr = std::uniform_int_distribution<int>{ lo, hi };
+
+        const auto offsets = std::vector<size_t>{ 0, 3, 300003, 300004, 300009, 700000 };
+        auto       values  = std::vector<int>(offsets.back());
+        for (auto &value : values)
+            value = distr(gen);
+
+        for (const size_t threads : { 1, 4 })
+        {
+            auto medians = std::vector<double>{};
+            auto grouped = values;
+            ::groupedMedians(grouped, offsets, threads, medians);
+
+            for (size_t g = 0; g + 1 < offsets.size(); ++g)
+            {
+                auto group = std::vector<int>(values.begin() + offsets[g], values.begin() + offsets[g + 1]);
+                ASSERT_EQ(medians[g], referenceMedian(group))
+                    << "groupedMedians: wrong median of group " << g << ", threads = " << threads;
+
+                auto reordered = std::vector<int>(grouped.begin() + offsets[g], grouped.begin() + offsets[g + 1]);
+                std::sort(group.begin(), group.end());
+                std::sort(reordered.begin(), reordered.end());
+                ASSERT_EQ(reordered, group) << "groupedMedians: values moved between groups";
+            }
+
+            for (const double q : { 0.0, 0.3, 1.0 })
+            {
+                auto quantiles = std::vector<int>{};
+                auto copy      = values;
+                ::groupedQuantiles(copy, offsets, q, threads, quantiles);
+
+                for (size_t g = 0; g + 1 < offsets.size(); ++g)
+                {
+                    auto group = std::vector<int>(values.begin() + offsets[g], values.begin() + offsets[g + 1]);
+                    const auto rank = std::clamp<size_t>(static_cast<size_t>(std::ceil(q * group.size())), 1, group.size());
+                    std::nth_element(group.begin(), group.begin() + (rank - 1), group.end());
+                    ASSERT_EQ(quantiles[g], group[rank - 1])
+                        << "groupedQuantiles: wrong quantile " << q << " of group " << g << ", threads = " << threads;
+                }
+            }
+        }
+    }
+}
+
 }    // namespace Utils::Median
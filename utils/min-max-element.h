@@ -2,8 +2,10 @@
 
 #include <algorithm>
 #include <limits>
+#include <map>
 #include <random>
 #include <sstream>
+#include <tuple>
 #include <vector>
 
 #include <benchmark/benchmark.h>
@@ -13,9 +15,22 @@
 #include "main.h"
 
 extern const std::vector<long long> Ns;
+extern const std::vector<long long> slidingNs;
+extern const std::vector<long long> slidingWindows;
+extern const std::vector<long long> slidingBatchSeries;
+extern const std::vector<long long> frequencyNs;
+extern const long long heavyHittersM;
+extern const long long heavyHittersCounters;
 
 std::pair<int, int> minMaxElement(const std::vector<int> &);
 
+void slidingMinMax(const std::vector<int> &, size_t, std::vector<int> &, std::vector<int> &);
+void slidingMinMaxBatch(
+    const std::vector<std::vector<int>> &,
+    size_t,
+    std::vector<std::vector<int>> &,
+    std::vector<std::vector<int>> &);
+
 namespace Utils::MinMaxElement
 {
 struct Test
@@ -118,6 +133,300 @@ BENCHMARK(BM_minMaxElement)
             b->Name("MinMaxElement");
         });
 
+/**
+ * @brief rolling min/max over all state.range(1) long windows of
+ * state.range(0) values: slidingMinMax, or (naive = true) minMaxElement on a
+ * copy of every window
+ */
+static void BM_slidingMinMax(benchmark::State &state, bool naive)
+{
+    auto gen = std::mt19937{ 47 };
+
+    auto distr = std::uniform_int_distribution<int>{ std::numeric_limits<int>::min(),
+                                                     std::numeric_limits<int>::max() };
+
+    const auto n      = static_cast<int>(state.range(0));
+    const auto window = static_cast<int>(state.range(1));
+    if (window <= 0 || window > n)
+        throw InternalError{ "BM_impl: window should be in [1, n]" };
+
+    auto mins  = std::vector<int>{};
+    auto maxs  = std::vector<int>{};
+    auto slice = std::vector<int>{};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto v = std::vector<int>{};
+        v.reserve(n);
+
+        for (int i = 0; i < n; ++i)
+            v.push_back(distr(gen));
+
+        state.ResumeTiming();
+
+        if (naive)
+        {
+            mins.resize(n - window + 1);
+            maxs.resize(n - window + 1);
+            for (int i = 0; i + window <= n; ++i)
+            {
+                slice.assign(v.begin() + i, v.begin() + i + window);
+                std::tie(mins[i], maxs[i]) = minMaxElement(slice);
+            }
+        }
+        else
+        {
+            slidingMinMax(v, window, mins, maxs);
+        }
+        ::benchmark::DoNotOptimize(mins.data());
+        ::benchmark::DoNotOptimize(maxs.data());
+    }
+}
+
+/**
+ * @brief state.range(0) series of slidingNs.front() values with windows of
+ * state.range(1): one slidingMinMaxBatch call, or (perSeries = true) one
+ * slidingMinMax call per series
+ */
+static void BM_slidingMinMaxBatch(benchmark::State &state, bool perSeries)
+{
+    auto gen = std::mt19937{ 47 };
+
+    auto distr = std::uniform_int_distribution<int>{ std::numeric_limits<int>::min(),
+                                                     std::numeric_limits<int>::max() };
+
+    const auto count  = static_cast<int>(state.range(0));
+    const auto n      = static_cast<int>(slidingNs.front());
+    const auto window = static_cast<int>(state.range(1));
+    if (window <= 0 || window > n)
+        throw InternalError{ "BM_impl: window should be in [1, n]" };
+
+    auto mins = std::vector<std::vector<int>>{};
+    auto maxs = std::vector<std::vector<int>>{};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto series = std::vector<std::vector<int>>(count);
+        for (auto &v : series)
+        {
+            v.reserve(n);
+            for (int i = 0; i < n; ++i)
+                v.push_back(distr(gen));
+        }
+
+        state.ResumeTiming();
+
+        if (perSeries)
+        {
+            mins.resize(count);
+            maxs.resize(count);
+            for (int i = 0; i < count; ++i)
+                slidingMinMax(series[i], window, mins[i], maxs[i]);
+        }
+        else
+        {
+            slidingMinMaxBatch(series, window, mins, maxs);
+        }
+        ::benchmark::DoNotOptimize(mins.data());
+        ::benchmark::DoNotOptimize(maxs.data());
+    }
+}
+
+BENCHMARK_CAPTURE(BM_slidingMinMax, Deques, false)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            for (const auto &n : slidingNs)
+            {
+                for (const auto &window : slidingWindows)
+                {
+                    if (window <= n)
+                        b->Args({ n, window });
+                }
+            }
+
+            b->Name("SlidingMinMax");
+        });
+
+BENCHMARK_CAPTURE(BM_slidingMinMax, Naive, true)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            for (const auto &n : slidingNs)
+            {
+                for (const auto &window : slidingWindows)
+                {
+                    if (window <= n)
+                        b->Args({ n, window });
+                }
+            }
+
+            b->Name("SlidingMinMax/NaiveMinMaxElement");
+        });
+
+BENCHMARK_CAPTURE(BM_slidingMinMaxBatch, Batch, false)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            for (const auto &count : slidingBatchSeries)
+            {
+                for (const auto &window : slidingWindows)
+                    b->Args({ count, window });
+            }
+
+            b->Name("SlidingMinMaxBatch");
+        });
+
+BENCHMARK_CAPTURE(BM_slidingMinMaxBatch, PerSeries, true)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            for (const auto &count : slidingBatchSeries)
+            {
+                for (const auto &window : slidingWindows)
+                    b->Args({ count, window });
+            }
+
+            b->Name("SlidingMinMaxBatch/PerSeries");
+        });
+
+enum class FrequencyMethod
+{
+    Sort,
+    Radix,
+    Hash,
+    MisraGries,
+};
+
+/**
+ * @brief state.range(0) values uniform in [-1000, 1000] (state.range(1) = 0)
+ * or in the whole int range (state.range(1) = 1): heavyHittersM heavy hitters
+ * (state.range(2) = 0) or the mode, its count and the number of distinct values
+ * (state.range(2) = 1) by @p method; Sort is the std::sort + scan baseline,
+ * MisraGries only finds heavy hitters
+ */
+static void BM_frequencyStats(benchmark::State &state, FrequencyMethod method)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const bool fullRange = state.range(1) != 0;
+    auto distr           = fullRange ? std::uniform_int_distribution<int>{ std::numeric_limits<int>::min(),
+                                                                           std::numeric_limits<int>::max() }
+                                     : std::uniform_int_distribution<int>{ -1000, 1000 };
+
+    const auto n     = static_cast<int>(state.range(0));
+    const auto m     = static_cast<size_t>(heavyHittersM);
+    const bool stats = state.range(2) != 0;
+    if (stats && method == FrequencyMethod::MisraGries)
+        throw InternalError{ "BM_frequencyStats: MisraGries has no frequency statistics" };
+
+    auto top     = std::vector<ValueCount>{};
+    auto summary = FrequencyStats{};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto v = std::vector<int>{};
+        v.reserve(n);
+
+        for (int i = 0; i < n; ++i)
+            v.push_back(distr(gen));
+
+        state.ResumeTiming();
+
+        switch (method)
+        {
+        case FrequencyMethod::Sort:
+        {
+            std::sort(v.begin(), v.end());
+            auto groups = std::vector<ValueCount>{};
+            for (size_t i = 0; i < v.size();)
+            {
+                size_t j = i;
+                while (j < v.size() && v[j] == v[i])
+                    ++j;
+                groups.emplace_back(v[i], j - i);
+                i = j;
+            }
+            if (stats)
+                summary = frequencyStatsOf(groups);
+            else
+                top = topOf(std::move(groups), m);
+            break;
+        }
+        case FrequencyMethod::Radix:
+            if (stats)
+                summary = frequencyStatsSorted(v);
+            else
+                top = heavyHittersSorted(v, m);
+            break;
+        case FrequencyMethod::Hash:
+            if (stats)
+                summary = frequencyStatsHashed(v);
+            else
+                top = heavyHittersHashed(v, m);
+            break;
+        case FrequencyMethod::MisraGries:
+            top = heavyHittersStreaming(v, m, heavyHittersCounters);
+            break;
+        }
+        ::benchmark::DoNotOptimize(top.data());
+        ::benchmark::DoNotOptimize(summary);
+    }
+}
+
+static void frequencyArgs(benchmark::internal::Benchmark *b, bool withStats = true)
+{
+    for (const auto &n : frequencyNs)
+    {
+        for (const long long stats : { 0, 1 })
+        {
+            if (stats == 1 && !withStats)
+                continue;
+            b->Args({ n, 0, stats });
+            b->Args({ n, 1, stats });
+        }
+    }
+    b->ArgNames({ "n", "fullRange", "stats" });
+}
+
+BENCHMARK_CAPTURE(BM_frequencyStats, Sort, FrequencyMethod::Sort)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            frequencyArgs(b);
+            b->Name("FrequencyStats/StdSort");
+        });
+
+BENCHMARK_CAPTURE(BM_frequencyStats, Radix, FrequencyMethod::Radix)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            frequencyArgs(b);
+            b->Name("FrequencyStats/Radix");
+        });
+
+BENCHMARK_CAPTURE(BM_frequencyStats, Hash, FrequencyMethod::Hash)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            frequencyArgs(b);
+            b->Name("FrequencyStats/Hash");
+        });
+
+BENCHMARK_CAPTURE(BM_frequencyStats, MisraGries, FrequencyMethod::MisraGries)
+    ->Apply(
+        [](benchmark::internal::Benchmark *b)
+        {
+            frequencyArgs(b, false);
+            b->Name("FrequencyStats/MisraGries");
+        });
+
 class MinMaxElement : public ::testing::TestWithParam<Test>
 {
 };
@@ -142,4 +451,178 @@ INSTANTIATE_TEST_SUITE_P(
     MinMaxElement,
     ::testing::ValuesIn(getTests()));
 
+class SlidingMinMax : public ::testing::TestWithParam<std::tuple<size_t, Test>>
+{
+};
+
+TEST_P(SlidingMinMax, Correctness)
+{
+    const auto &[maxWindow, test] = GetParam();
+
+    const auto window = std::min(maxWindow, test.values.size());
+    const auto &v     = test.values;
+
+    auto mins = std::vector<int>{};
+    auto maxs = std::vector<int>{};
+    slidingMinMax(v, window, mins, maxs);
+
+    ASSERT_EQ(mins.size(), v.size() - window + 1)
+        << "slidingMinMax: wrong number of windows, window = " << window;
+    ASSERT_EQ(maxs.size(), v.size() - window + 1)
+        << "slidingMinMax: wrong number of windows, window = " << window;
+
+    for (size_t i = 0; i < mins.size(); ++i)
+    {
+        const auto expected =
+            minMaxElement(std::vector<int>(v.begin() + i, v.begin() + i + window));
+
+        ASSERT_EQ(mins[i], expected.first)
+            << "slidingMinMax: wrong min of window " << i << ", window = " << window
+            << ", values = " << toString(v);
+        ASSERT_EQ(maxs[i], expected.second)
+            << "slidingMinMax: wrong max of window " << i << ", window = " << window
+            << ", values = " << toString(v);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SlidingMinMaxTests,
+    SlidingMinMax,
+    ::testing::Combine(
+        ::testing::ValuesIn(std::vector<size_t>{ 1, 2, 3, 5, 40 }),
+        ::testing::ValuesIn(getTests())));
+
+TEST(SlidingMinMaxBatch, Correctness)
+{
+    for (const size_t window : { 1, 2, 3, 5 })
+    {
+        auto series = std::vector<std::vector<int>>{};
+        for (const auto &test : getTests())
+        {
+            if (test.values.size() >= window)
+                series.push_back(test.values);
+        }
+
+        auto mins = std::vector<std::vector<int>>{};
+        auto maxs = std::vector<std::vector<int>>{};
+        slidingMinMaxBatch(series, window, mins, maxs);
+
+        ASSERT_EQ(mins.size(), series.size());
+        ASSERT_EQ(maxs.size(), series.size());
+
+        for (size_t i = 0; i < series.size(); ++i)
+        {
+            auto expectedMins = std::vector<int>{};
+            auto expectedMaxs = std::vector<int>{};
+            slidingMinMax(series[i], window, expectedMins, expectedMaxs);
+
+            ASSERT_EQ(mins[i], expectedMins)
+                << "slidingMinMaxBatch: wrong mins, window = " << window
+                << ", values = " << toString(series[i]);
+            ASSERT_EQ(maxs[i], expectedMaxs)
+                << "slidingMinMaxBatch: wrong maxs, window = " << window
+                << ", values = " << toString(series[i]);
+        }
+    }
+}
+
+/**
+ * @brief value sets for the frequency statistics: getTests() plus larger
+ * vectors in [-1000, 1000], skewed ones and ones over the whole int range
+ */
+std::vector<std::vector<int>> getFrequencyTests()
+{
+    auto tests = std::vector<std::vector<int>>{};
+    for (const auto &test : getTests())
+        tests.push_back(test.values);
+
+    auto gen = std::mt19937{ 47 };
+    for (const int n : { 10, 100, 1000, 10000 })
+    {
+        auto small = std::uniform_int_distribution<int>{ -1000, 1000 };
+        auto tiny  = std::uniform_int_distribution<int>{ -3, 3 };
+        auto full  = std::uniform_int_distribution<int>{ std::numeric_limits<int>::min(),
+                                                         std::numeric_limits<int>::max() };
+        auto geom  = std::geometric_distribution<int>{ 0.2 };
+
+        auto a = std::vector<int>{}, b = a, c = a, d = a;
+        for (int i = 0; i < n; ++i)
+        {
+            a.push_back(small(gen));
+            b.push_back(tiny(gen));
+            c.push_back(full(gen));
+            d.push_back(geom(gen) - 1000);
+        }
+        tests.push_back(a);
+        tests.push_back(b);
+        tests.push_back(c);
+        tests.push_back(d);
+    }
+    return tests;
+}
+
+class FrequencyStatistics : public ::testing::TestWithParam<std::vector<int>>
+{
+};
+
+TEST_P(FrequencyStatistics, Correctness)
+{
+    const auto &v = GetParam();
+
+    auto reference = std::map<int, size_t>{};
+    for (const auto value : v)
+        ++reference[value];
+
+    auto expected = std::vector<ValueCount>(reference.begin(), reference.end());
+    std::stable_sort(expected.begin(), expected.end(), moreFrequent);
+
+    for (const auto &stats : { frequencyStatsSorted(v), frequencyStatsHashed(v) })
+    {
+        ASSERT_EQ(stats.mode, expected.front().first) << "frequencyStats: wrong mode, values = " << toString(v);
+        ASSERT_EQ(stats.modeCount, expected.front().second)
+            << "frequencyStats: wrong mode count, values = " << toString(v);
+        ASSERT_EQ(stats.distinct, reference.size())
+            << "frequencyStats: wrong distinct count, values = " << toString(v);
+    }
+
+    for (const size_t m : { 1, 3, 10, 100000 })
+    {
+        const auto top = std::vector<ValueCount>(
+            expected.begin(), expected.begin() + std::min(m, expected.size()));
+
+        ASSERT_EQ(heavyHittersSorted(v, m), top) << "heavyHittersSorted: m = " << m << ", values = " << toString(v);
+        ASSERT_EQ(heavyHittersHashed(v, m), top) << "heavyHittersHashed: m = " << m << ", values = " << toString(v);
+    }
+
+    for (const size_t counters : { 1, 2, 5, 50 })
+    {
+        const auto candidates = heavyHittersStreaming(v, counters, counters);
+        const auto bound      = v.size() / (counters + 1);
+
+        ASSERT_LE(candidates.size(), counters);
+        for (const auto &[value, estimate] : candidates)
+        {
+            const auto it = reference.find(value);
+            ASSERT_NE(it, reference.end()) << "heavyHittersStreaming: reported a value not in v";
+            ASSERT_LE(estimate, it->second) << "heavyHittersStreaming: overestimated count of " << value;
+            ASSERT_LE(it->second - estimate, bound)
+                << "heavyHittersStreaming: count of " << value << " off by more than n / (counters + 1)";
+        }
+        for (const auto &[value, count] : reference)
+        {
+            if (count <= bound)
+                continue;
+            ASSERT_TRUE(std::any_of(
+                candidates.begin(), candidates.end(), [&](const ValueCount &c) { return c.first == value; }))
+                << "heavyHittersStreaming: missed " << value << " occurring " << count
+                << " times, counters = " << counters;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    FrequencyStatisticsTests,
+    FrequencyStatistics,
+    ::testing::ValuesIn(getFrequencyTests()));
+
 }    // namespace Utils::MinMaxElement
@@ -5,6 +5,7 @@
 #include <ostream>
 #include <random>
 #include <sstream>
+#include <stdexcept>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -23,7 +24,11 @@ size_t uniformRandomMedianPivot(int *data, size_t n);
 void quickSortSimplePivot(std::vector<int> &v, Pivot_f pivotFunction);
 void quickSortMedianPivot(std::vector<int> &v, Pivot_f pivotFunction);
 
-extern const BenchmarkData benchmarksData;
+std::vector<int> topK(std::vector<int> &v, int k, Pivot_f pivotFunction);
+std::vector<int> streamingTopK(const std::vector<int> &v, int k);
+
+extern const BenchmarkData           benchmarksData;
+extern const std::vector<long long> topKNs;
 
 namespace Utils::QuickSort
 {
@@ -39,6 +44,10 @@ QuickSort_f getQuickSortF(PivotPolicy pivotPolicy)
     case PivotPolicy::MedianDeterministic:
     case PivotPolicy::MedianUniformRandom:
         return &::quickSortMedianPivot;
+    case PivotPolicy::Introselect:
+    case PivotPolicy::FloydRivest:
+        // selection-only policies
+        break;
     }
 
     throw InternalError{ "quicksort.h: quick sort function cannot be nullptr" };
@@ -56,6 +65,10 @@ Pivot_f getPivotF(PivotPolicy pivotPolicy)
         return &::deterministicMedianPivot;
     case PivotPolicy::MedianUniformRandom:
         return &::uniformRandomMedianPivot;
+    case PivotPolicy::Introselect:
+    case PivotPolicy::FloydRivest:
+        // selection-only policies
+        break;
     }
 
     throw InternalError{ "quickSort.h: pivot function cannot be nullptr" };
@@ -169,6 +182,101 @@ static void BM_quickSort(
     }
 }
 
+enum class TopKMethod
+{
+    Select,
+    Stream,
+    Sort
+};
+
+std::ostream &operator<<(std::ostream &strm, TopKMethod rhs)
+{
+    switch (rhs)
+    {
+    case TopKMethod::Select:
+        return strm << "Select";
+    case TopKMethod::Stream:
+        return strm << "Stream";
+    case TopKMethod::Sort:
+        return strm << "Sort";
+    }
+
+    return strm << "Unknown";
+}
+
+/**
+ * @brief k = state.range(1) largest of state.range(0) values in descending
+ * order: topK (selection + sort of the tail), streamingTopK (bounded heap) or
+ * a full quickSort followed by a copy of the tail
+ */
+static void BM_topK(
+    benchmark::State &state,
+    PivotPolicy       pivotPolicy,
+    InputData         inputData,
+    TopKMethod        method)
+{
+    auto gen = std::mt19937{ 47 };
+
+    const auto n = static_cast<int>(state.range(0));
+    const auto k = static_cast<int>(state.range(1));
+    if (n < 0 || k < 0)
+        throw InternalError{ "BM_impl: n and k cannot be negative" };
+
+    auto valuesDistr = std::uniform_int_distribution<int>{ -1000000, 1000000 };
+
+    QuickSort_f quickSort = getQuickSortF(pivotPolicy);
+    Pivot_f     pivot     = getPivotF(pivotPolicy);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+
+        auto values = std::vector<int>{};
+        values.reserve(n);
+
+        for (int i = 0; i < n; ++i)
+            values.push_back(valuesDistr(gen));
+
+        switch (inputData)
+        {
+        case InputData::RandomArray:
+            break;
+        case InputData::SortedArray:
+            std::sort(values.begin(), values.end());
+            break;
+        case InputData::ReversedSortedArray:
+            std::sort(values.begin(), values.end());
+            std::reverse(values.begin(), values.end());
+            break;
+        }
+
+        state.ResumeTiming();
+
+        switch (method)
+        {
+        case TopKMethod::Select:
+        {
+            auto res = ::topK(values, k, pivot);
+            ::benchmark::DoNotOptimize(res);
+            break;
+        }
+        case TopKMethod::Stream:
+        {
+            auto res = ::streamingTopK(values, k);
+            ::benchmark::DoNotOptimize(res);
+            break;
+        }
+        case TopKMethod::Sort:
+        {
+            quickSort(values, pivot);
+            auto res = std::vector<int>(values.rbegin(), values.rbegin() + k);
+            ::benchmark::DoNotOptimize(res);
+            break;
+        }
+        }
+    }
+}
+
 void registerBenchmarks()
 {
     const auto &data = ::benchmarksData.getData();
@@ -201,6 +309,36 @@ void registerBenchmarks()
             {
                 b->Arg(n);
             }
+
+            auto ns = it->second;
+            if (pivotPolicy == PivotPolicy::UniformRandom &&
+                inputData == InputData::RandomArray)
+                ns.insert(ns.end(), ::topKNs.begin(), ::topKNs.end());
+
+            for (const auto method :
+                 { TopKMethod::Select, TopKMethod::Stream, TopKMethod::Sort })
+            {
+                const auto topKName =
+                    (std::stringstream{} << "topK/" << pivotPolicy << "Pivot/"
+                                         << inputData << "/" << method)
+                        .str();
+
+                auto topKBenchmark = benchmark::RegisterBenchmark(
+                    topKName, BM_topK, pivotPolicy, inputData, method);
+
+                for (const auto &n : ns)
+                {
+                    auto ks = std::vector<long long>{ 1, n / 1000, n / 100, n / 10 };
+                    ks.erase(
+                        std::remove_if(
+                            ks.begin(), ks.end(), [](long long k) { return k < 1; }),
+                        ks.end());
+                    ks.erase(std::unique(ks.begin(), ks.end()), ks.end());
+
+                    for (const auto k : ks)
+                        topKBenchmark->Args({ n, k });
+                }
+            }
         }
     }
 }
@@ -287,4 +425,71 @@ INSTANTIATE_TEST_SUITE_P(
         ::testing::ValuesIn({ PivotPolicy::MedianUniformRandom }),
         ::testing::ValuesIn(getTests())));
 
+class TopK : public QuickSort
+{
+};
+
+TEST_P(TopK, Correctness)
+{
+    const auto &[pivotPolicy, test] = GetParam();
+
+    Pivot_f pivot = getPivotF(pivotPolicy);
+
+    const int n = test.values.size();
+
+    for (const auto k : { 0, 1, 2, n / 10, n / 2, n - 1, n, n + 1 })
+    {
+        if (k < 0)
+            continue;
+
+        const auto count    = std::min(k, n);
+        const auto expected = std::vector<int>(
+            test.sortedValues.rbegin(), test.sortedValues.rbegin() + count);
+
+        auto values = test.values;
+        ASSERT_EQ(::topK(values, k, pivot), expected)
+            << "Wrong topK, PivotPolicy = " << pivotPolicy << ", k = " << k
+            << ", input values = " << toString(test.values);
+
+        ASSERT_EQ(::streamingTopK(test.values, k), expected)
+            << "Wrong streamingTopK, k = " << k
+            << ", input values = " << toString(test.values);
+
+        // push the stream in uneven chunks, so that filtered blocks start at
+        // arbitrary offsets and the heap fills up in the middle of a chunk
+        auto top = StreamingTopK{ static_cast<size_t>(k) };
+        for (int i = 0; i < n; i += 37)
+            top.push(test.values.data() + i, std::min(37, n - i));
+
+        ASSERT_EQ(top.values(), expected)
+            << "Wrong StreamingTopK pushed in chunks, k = " << k
+            << ", input values = " << toString(test.values);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicPivot,
+    TopK,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::Deterministic }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    UniformRandomPivot,
+    TopK,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::UniformRandom }),
+        ::testing::ValuesIn(getTests())));
+INSTANTIATE_TEST_SUITE_P(
+    DeterministicMedianPivot,
+    TopK,
+    ::testing::Combine(
+        ::testing::ValuesIn({ PivotPolicy::MedianDeterministic }),
+        ::testing::ValuesIn(getTests())));
+
+TEST(TopK, PivotOutsideOfWindow)
+{
+    auto values = std::vector<int>{ 5, 1, 4, 2, 3 };
+    EXPECT_THROW(::topK(values, 2, [](int *, size_t n) { return n + 1; }), std::runtime_error);
+}
+
 }    // namespace Utils::QuickSort